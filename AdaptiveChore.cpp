@@ -0,0 +1,115 @@
+/*********************************************************************
+  AdaptiveChore.cpp - chore with a load dependent period.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "AdaptiveChore.h"
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * A chore is created that runs at its shortest period.
+ *
+ * @param[in] min_period - shortest period, milli-seconds
+ * @param[in] max_period - longest period, milli-seconds
+ * @param[in] pri - priority, higher is stretched later
+ */
+
+AdaptiveChore::
+AdaptiveChore (uint32_t min_period, uint32_t max_period, uint8_t pri)
+  : SchedulerChore (min_period)
+{
+  Periods (min_period, max_period);
+  Priority (pri);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Set periods.
+ *
+ * The chore is set to its shortest period.  The longest period is
+ * raised to the shortest if it is less.
+ *
+ * @param[in] min_period - shortest period, milli-seconds
+ * @param[in] max_period - longest period, milli-seconds
+ */
+
+void AdaptiveChore::
+Periods (uint32_t min_period, uint32_t max_period)
+{
+  m_minPeriod = min_period;
+  m_maxPeriod = (max_period < min_period) ? min_period : max_period;
+  Interval (m_minPeriod);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Get period for a degrade level.
+ *
+ * @param[in] level - scheduler degrade level
+ * @return period this chore runs at, milli-seconds.
+ */
+
+uint32_t AdaptiveChore::
+PeriodFor (uint8_t level) const
+{
+  if (level <= Priority())
+    {
+      return (m_minPeriod);
+    }
+
+  uint8_t steps = level - Priority();
+  if (steps >= SCHEDULER_ADAPT_STEPS)
+    {
+      return (m_maxPeriod);
+    }
+
+  return m_minPeriod + (m_maxPeriod - m_minPeriod) / SCHEDULER_ADAPT_STEPS * steps;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Run chore.
+ *
+ * The period is set from the degrade level of the scheduler, and
+ * the chore is processed.  The new period takes effect when the
+ * chore is rescheduled.
+ */
+
+void AdaptiveChore::
+Run ()
+{
+#if defined (SCHEDULER_ADAPTIVE)
+  if (Parent() != 0)
+    {
+      uint32_t period = PeriodFor (Parent()->AdaptLevel());
+      if (period != Interval())
+        {
+          Interval (period);
+        }
+    }
+#endif
+
+  Process();
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
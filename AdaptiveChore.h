@@ -0,0 +1,93 @@
+/*********************************************************************
+  AdaptiveChore.h - chore with a load dependent period.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (AdaptiveChore_H_)
+#define AdaptiveChore_H_
+
+#include <Scheduler.h>
+
+// ----------------------------------------------------------------------------
+/** Adaptive rate chore.
+ *
+ * This class is the base class for chores that can run less
+ * often when the scheduler falls behind, such as a display
+ * refresh or a logger.  The chore is given the shortest and the
+ * longest period it may run at, and a priority.  Normally it runs
+ * at its shortest period.  When SCHEDULER_ADAPTIVE is defined and
+ * the scheduler raises its degrade level, the chores with the
+ * lowest priority are stretched first, one step for each level
+ * above their priority, up to SCHEDULER_ADAPT_STEPS steps at the
+ * longest period.  As the level falls again, they return to their
+ * shortest period.
+ *
+ * The period is picked each time the chore runs, so a chore
+ * follows the level within one of its periods.  Derived classes
+ * supply Process() in place of Run().
+ *
+ * Example:
+\code
+class display_chore : public AdaptiveChore
+{
+public:
+  display_chore() : AdaptiveChore (50, 500) { }
+
+private:
+  virtual void Process() { refresh_display(); }
+};
+\endcode
+ */
+
+class AdaptiveChore
+  : public SchedulerChore
+{
+public:
+  AdaptiveChore (uint32_t min_period, uint32_t max_period, uint8_t pri = 0);
+
+  /// Return shortest period, milli-seconds.
+  uint32_t MinPeriod() const { return m_minPeriod; }
+
+  /// Return longest period, milli-seconds.
+  uint32_t MaxPeriod() const { return m_maxPeriod; }
+
+  void Periods (uint32_t min_period, uint32_t max_period);
+
+  uint32_t PeriodFor (uint8_t level) const;
+
+
+protected:
+  /** Procedure to run.  This method is the do-it function for
+   * this chore, run at the current period.
+   */
+  virtual void Process () = 0;
+
+
+private:
+  virtual void Run ();
+
+  uint32_t m_minPeriod;
+  uint32_t m_maxPeriod;
+};
+
+#endif	// AdaptiveChore_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
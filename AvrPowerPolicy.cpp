@@ -0,0 +1,128 @@
+/*********************************************************************
+  AvrPowerPolicy.cpp - sleep modes of an AVR for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "AvrPowerPolicy.h"
+
+#if defined (__AVR__)
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#endif
+
+
+namespace {
+
+// Number of watchdog periods, each twice the one before.
+const uint8_t WDT_PERIODS = 10;
+
+#if defined (__AVR__) && defined (SCHEDULER_POWER_WDT)
+volatile bool s_woken = false;
+#endif
+
+} // end namespace
+
+
+#if defined (__AVR__) && defined (SCHEDULER_POWER_WDT)
+ISR (WDT_vect)
+{
+  s_woken = true;
+}
+#endif
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * The watchdog period is taken to be the nominal 16 milli-seconds.
+ */
+
+AvrPowerPolicy::
+AvrPowerPolicy()
+  : m_period (16000)
+{
+}
+
+
+// ----------------------------------------------------------------------------
+/** Sleep while idle.
+ *
+ * @param[in] idle - time until the next chore, milli-seconds
+ * @return time the millis() clock was stopped, milli-seconds.
+ */
+
+uint32_t AvrPowerPolicy::
+Sleep (uint32_t idle)
+{
+#if defined (__AVR__)
+# if defined (SCHEDULER_POWER_WDT)
+  // find the longest watchdog period that fits
+  int8_t wdp = -1;
+  uint32_t slept = 0;
+
+  for (uint8_t p = 0; p < WDT_PERIODS; ++p)
+    {
+      uint32_t ms = ((uint32_t) m_period << p) / 1000;
+      if (ms + SCHEDULER_WAKE_LATENCY > idle)
+        {
+          break;
+        }
+
+      wdp = p;
+      slept = ms;
+    }
+
+  if (wdp >= 0)
+    {
+      uint8_t bits = (wdp & 7) | ((wdp & 8) ? _BV(WDP3) : 0);
+
+      s_woken = false;
+
+      cli();
+      wdt_reset();
+      MCUSR &= ~_BV(WDRF);
+      WDTCSR = _BV(WDCE) | _BV(WDE);
+      WDTCSR = _BV(WDIE) | bits;
+
+      set_sleep_mode (SLEEP_MODE_PWR_DOWN);
+      sleep_enable();
+      sei();
+      sleep_cpu();
+      sleep_disable();
+
+      wdt_disable();
+
+      return (s_woken ? slept : 0);
+    }
+# endif
+
+  // timer 0 wakes us within a milli-second
+  set_sleep_mode (SLEEP_MODE_IDLE);
+  sleep_mode();
+#else
+  (void) idle;
+#endif
+
+  return (0);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
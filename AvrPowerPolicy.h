@@ -0,0 +1,78 @@
+/*********************************************************************
+  AvrPowerPolicy.h - sleep modes of an AVR for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (AvrPowerPolicy_H_)
+#define AvrPowerPolicy_H_
+
+#include <Scheduler.h>
+
+// ----------------------------------------------------------------------------
+/** AVR power policy.
+ *
+ * This class puts an AVR to sleep while the scheduler is idle.
+ * Short idle times are spent in idle mode, where timer 0 keeps
+ * running, so millis() counts and the timer interrupt wakes the
+ * board each milli-second to check the schedule.
+ *
+ * When SCHEDULER_POWER_WDT is defined in SchedulerConfig.h and the
+ * idle time is long enough, the board is put in power down mode
+ * instead and woken by the watchdog timer.  The longest watchdog
+ * period that, with SCHEDULER_WAKE_LATENCY, fits in the idle
+ * time is used, from 16 milli-seconds to 8 seconds.  The clock
+ * behind millis() is stopped in power down, so the period is
+ * returned for the scheduler to add to its clock.  The watchdog
+ * oscillator is only accurate to about ten percent, which can be
+ * corrected with Calibrate().  If another interrupt wakes the
+ * board first, the time asleep is not known and is not counted.
+ *
+ * Example:
+\code
+AvrPowerPolicy  power;
+
+void setup()
+{
+  the_scheduler.Power (& power);
+}
+\endcode
+ */
+
+class AvrPowerPolicy
+  : public PowerPolicy
+{
+public:
+  AvrPowerPolicy();
+
+  virtual uint32_t Sleep (uint32_t idle);
+
+  /// Set length of a nominal 16 msec watchdog period, micro-seconds.
+  void Calibrate (uint16_t usec) { m_period = usec; }
+
+
+private:
+  /// Watchdog period, micro-seconds.
+  uint16_t m_period;
+};
+
+#endif	// AvrPowerPolicy_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,167 @@
+/*********************************************************************
+
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (ChoreMessageQueue_H_)
+#define ChoreMessageQueue_H_
+
+#include <Scheduler.h>
+
+// ------------------------------------------------------------------
+/** Message queue between chores.
+ *
+ * This class is a fixed size ring buffer of messages passed from
+ * one producer chore to one consumer chore. Messages are built
+ * and read in place in the ring, so large messages such as
+ * sample buffers are never copied.
+ *
+ * When a message is committed to an empty queue, the consumer
+ * chore is triggered, so it runs in the current pass of the
+ * scheduler instead of polling the queue. The consumer is
+ * usually an event chore (zero interval), and it must empty the
+ * queue each time it runs.
+ *
+ * The number of slots must be a power of two, no more than 128.
+ *
+ * Example:
+\code
+ChoreMessageQueue < sample_block, 4 > samples (& filter);
+
+// in the producer's Run()
+sample_block * blk = samples.Reserve();
+if (blk != 0)
+  {
+    read_adc (blk->data);
+    samples.Commit();
+  }
+
+// in the consumer's Run()
+for (sample_block * blk; (blk = samples.Front()) != 0; samples.Pop())
+  {
+    filter (blk->data);
+  }
+\endcode
+ */
+
+template < class T, uint8_t N >
+class ChoreMessageQueue
+{
+public:
+  ChoreMessageQueue (SchedulerChore * consumer = 0)
+    : m_consumer (consumer),
+      m_head (0),
+      m_tail (0)
+  { }
+
+  /// Set chore to wake when a message is committed.
+  void Consumer (SchedulerChore * consumer) { m_consumer = consumer; }
+
+  /// Return number of messages in the queue.
+  uint8_t Count() const { return (uint8_t) (m_tail - m_head); }
+
+  bool IsEmpty() const { return (m_tail == m_head); }
+  bool IsFull() const { return (Count() == N); }
+
+  /** Reserve a slot for the next message.  The message is built
+   * in the returned slot and made visible by Commit().
+   *
+   * @return slot to fill, or 0 if the queue is full.
+   */
+  T * Reserve()
+  {
+    if (IsFull())
+      {
+        return (0);
+      }
+
+    return & m_slots[m_tail & (N - 1)];
+  }
+
+  /// Publish the reserved message and wake the consumer.
+  void Commit()
+  {
+    ++m_tail;
+
+    if (Count() == 1 && m_consumer != 0)
+      {
+        m_consumer->Trigger();
+      }
+  }
+
+  /// Copy a message into the queue.
+  bool Push (const T & msg)
+  {
+    T * slot = Reserve();
+    if (slot == 0)
+      {
+        return (false);
+      }
+
+    *slot = msg;
+    Commit();
+    return (true);
+  }
+
+  /** Return the oldest message in place.
+   *
+   * @return oldest message, or 0 if the queue is empty.
+   */
+  T * Front()
+  {
+    if (IsEmpty())
+      {
+        return (0);
+      }
+
+    return & m_slots[m_head & (N - 1)];
+  }
+
+  /// Release the oldest message.
+  void Pop()
+  {
+    if (! IsEmpty())
+      {
+        ++m_head;
+      }
+  }
+
+
+private:
+  // slot count must be a power of two that fits the indexes
+  typedef char SizeCheck[((N & (N - 1)) == 0 && N != 0 && N <= 128) ? 1 : -1];
+
+  SchedulerChore * m_consumer;
+
+  // free running indexes, masked on use
+  uint8_t m_head;
+  uint8_t m_tail;
+
+  T m_slots[N];
+
+  // NON_COPYABLE
+  ChoreMessageQueue (const ChoreMessageQueue &);
+  const ChoreMessageQueue & operator= (const ChoreMessageQueue &);
+};
+
+#endif
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,389 @@
+/*********************************************************************
+  CompactScheduler.cpp - small memory scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "CompactScheduler.h"
+
+#include "WProgram.h"
+
+
+CompactScheduler * CompactScheduler::s_schedulers = 0;
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * An empty scheduler is created.
+ */
+
+CompactScheduler::
+CompactScheduler()
+{
+  Register();
+}
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * An empty scheduler is created, that runs as a chore with the
+ * specified interval.
+ *
+ * @param[in] inter - interval, milli-seconds
+ */
+
+CompactScheduler::
+CompactScheduler (uint32_t inter)
+  : SchedulerChore (inter)
+{
+  Register();
+}
+
+
+// ----------------------------------------------------------------------------
+/** Destructor.
+ *
+ * All chores are aborted.
+ */
+
+CompactScheduler::
+~CompactScheduler()
+{
+  AbortAllChores();
+
+  // remove from list of schedulers
+  for (CompactScheduler ** pp = & s_schedulers; *pp != 0; pp = & (*pp)->m_nextScheduler)
+    {
+      if (*pp == this)
+        {
+          *pp = m_nextScheduler;
+          break;
+        }
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Set up empty scheduler.
+ *
+ */
+
+void CompactScheduler::
+Register ()
+{
+  for (uint8_t i = 0; i < SCHEDULER_COMPACT_CHORES; ++i)
+    {
+      m_table[i] = 0;
+    }
+
+  m_head = CompactChore::NIL;
+  m_listTime = Scheduler::Millis();
+
+  m_nextScheduler = s_schedulers;
+  s_schedulers = this;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Run scheduler.
+ *
+ * All chores that have expired are run and rescheduled, one
+ * interval after the time they expired.
+ */
+
+void CompactScheduler::
+RunScheduler ()
+{
+  while (m_head != CompactChore::NIL)
+    {
+      CompactChore * chore = m_table[m_head];
+      uint32_t target = m_listTime + chore->m_delta;
+
+      if ((int32_t) (target - Scheduler::Millis()) > 1)
+        {
+          break; // no chores to dispatch
+        }
+
+      // take chore from the head, the next chore's delta is now
+      // counted from this chore's time
+      uint8_t slot = m_head;
+      m_head = chore->m_next;
+      m_listTime = target;
+
+      chore->Run();
+
+      // reschedule unless aborted while running
+      if (chore->m_slot == slot && m_table[slot] == chore)
+        {
+          Insert (chore, (int32_t) (target - m_listTime) + chore->m_interval);
+        }
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Schedule a chore.
+ *
+ * The chore first expires one interval from now.
+ *
+ * @param[in] chore - chore to schedule
+ * @retval 0 - chore scheduled
+ * @retval -1 - chore already scheduled, has no interval, or the
+ * table is full
+ */
+
+int CompactScheduler::
+Schedule (CompactChore * chore)
+{
+  if (chore->IsScheduled() || chore->m_interval == 0)
+    {
+      return (-1);
+    }
+
+  uint8_t slot = 0;
+  while (slot < SCHEDULER_COMPACT_CHORES && m_table[slot] != 0)
+    {
+      ++slot;
+    }
+
+  if (slot == SCHEDULER_COMPACT_CHORES)
+    {
+      return (-1);
+    }
+
+  m_table[slot] = chore;
+  chore->m_slot = slot;
+
+  uint32_t now = Scheduler::Millis();
+  AdvanceTo (now);
+  Insert (chore, (int32_t) (now - m_listTime) + chore->m_interval);
+
+  return (0);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Abort a chore.
+ *
+ * @param[in] chore - chore to abort
+ * @retval 0 - chore aborted
+ * @retval -1 - chore not scheduled here
+ */
+
+int CompactScheduler::
+AbortChore (CompactChore * chore)
+{
+  uint8_t slot = chore->m_slot;
+
+  if (slot >= SCHEDULER_COMPACT_CHORES || m_table[slot] != chore)
+    {
+      return (-1);
+    }
+
+  Unlink (chore);
+
+  m_table[slot] = 0;
+  chore->m_slot = CompactChore::NIL;
+
+  return (0);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Abort all chores.
+ *
+ */
+
+void CompactScheduler::
+AbortAllChores ()
+{
+  for (uint8_t i = 0; i < SCHEDULER_COMPACT_CHORES; ++i)
+    {
+      if (m_table[i] != 0)
+        {
+          m_table[i]->m_slot = CompactChore::NIL;
+          m_table[i]->m_next = CompactChore::NIL;
+          m_table[i] = 0;
+        }
+    }
+
+  m_head = CompactChore::NIL;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Insert chore into the list.
+ *
+ * The list is walked from the head, summing the deltas, to find
+ * the place of the chore.  The delta of the chore after it is
+ * reduced by the chore's delta.
+ *
+ * @param[in] chore - chore to insert
+ * @param[in] offset - expiration time, msec after the list time
+ */
+
+void CompactScheduler::
+Insert (CompactChore * chore, int32_t offset)
+{
+  // a late chore may be due before the list time
+  if (offset < 0)
+    {
+      offset = 0;
+    }
+  else if (offset > 0xffff)
+    {
+      offset = 0xffff;
+    }
+
+  uint16_t remain = offset;
+  uint8_t * link = & m_head;
+
+  while (*link != CompactChore::NIL)
+    {
+      CompactChore * cur = m_table[*link];
+      if (cur->m_delta > remain)
+        {
+          cur->m_delta -= remain;
+          break;
+        }
+
+      remain -= cur->m_delta;
+      link = & cur->m_next;
+    }
+
+  chore->m_delta = remain;
+  chore->m_next = *link;
+  *link = chore->m_slot;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Remove chore from the list.
+ *
+ * The chore's delta is added to the chore after it.  A chore that
+ * is running is not in the list.
+ *
+ * @param[in] chore - chore to remove
+ */
+
+void CompactScheduler::
+Unlink (CompactChore * chore)
+{
+  uint8_t * link = & m_head;
+
+  while (*link != CompactChore::NIL)
+    {
+      if (*link == chore->m_slot)
+        {
+          *link = chore->m_next;
+          if (chore->m_next != CompactChore::NIL)
+            {
+              m_table[chore->m_next]->m_delta += chore->m_delta;
+            }
+          break;
+        }
+
+      link = & m_table[*link]->m_next;
+    }
+
+  chore->m_next = CompactChore::NIL;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Move the list time forward.
+ *
+ * The list time is moved towards now, but not past the head, so
+ * the offset of a new chore fits 16 bits.
+ *
+ * @param[in] now - current time
+ */
+
+void CompactScheduler::
+AdvanceTo (uint32_t now)
+{
+  int32_t gap = (int32_t) (now - m_listTime);
+  if (gap <= 0)
+    {
+      return;
+    }
+
+  if (m_head == CompactChore::NIL)
+    {
+      m_listTime = now;
+      return;
+    }
+
+  CompactChore * head = m_table[m_head];
+  uint16_t step = (gap < head->m_delta) ? gap : head->m_delta;
+
+  head->m_delta -= step;
+  m_listTime += step;
+}
+
+
+// ============================================================================
+// Compact Chore methods
+//
+
+CompactChore::
+CompactChore()
+  : m_interval (0),
+    m_delta (0),
+    m_next (NIL),
+    m_slot (NIL)
+{ }
+
+
+CompactChore::
+CompactChore (uint16_t inter)
+  : m_interval (inter),
+    m_delta (0),
+    m_next (NIL),
+    m_slot (NIL)
+{ }
+
+
+// ----------------------------------------------------------------------------
+/** Destructor.
+ *
+ * The chore is aborted from the scheduler that holds it.
+ */
+
+CompactChore::
+~CompactChore()
+{
+  if (m_slot == NIL)
+    {
+      return;
+    }
+
+  for (CompactScheduler * s = CompactScheduler::s_schedulers; s != 0; s = s->m_nextScheduler)
+    {
+      if (s->AbortChore (this) == 0)
+        {
+          break;
+        }
+    }
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,170 @@
+/*********************************************************************
+  CompactScheduler.h - small memory scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (CompactScheduler_H_)
+#define CompactScheduler_H_
+
+#include <Scheduler.h>
+
+class CompactScheduler;
+
+// ----------------------------------------------------------------------------
+/** Compact chore.
+ *
+ * This class is the base class for chores run by a
+ * CompactScheduler.  It is used like a SchedulerChore, with a
+ * Run() method and an interval, but takes a fraction of the
+ * memory: the chore holds a 16 bit interval, a 16 bit expiration
+ * time relative to the chore before it, and the table index of
+ * the next chore, instead of two links, a parent pointer and two
+ * 32 bit times.  On AVR a compact chore is 8 bytes, plus 2 bytes
+ * for its entry in the scheduler's table.
+ *
+ * Intervals are limited to 65535 milli-seconds.  Event chores,
+ * triggers and dependencies are not supported.
+ */
+
+class CompactChore
+{
+public:
+  CompactChore ();
+  CompactChore (uint16_t inter);
+  virtual ~CompactChore();
+
+  /// Return scheduling interval for this chore.
+  uint16_t Interval() const { return m_interval; }
+
+  /// Set reschedule interval for this chore.
+  void Interval (uint16_t inter) { m_interval = inter; }
+
+  /// Return true if this chore is scheduled.
+  bool IsScheduled() const { return (m_slot != NIL); }
+
+  enum { NIL = 0xff };        // no chore index
+
+
+private:
+  friend class CompactScheduler;
+
+  /** Procedure to run periodically.  This method is the do-it
+   * function for this chore.  All derived classes must supply
+   * the implementation.
+   */
+  virtual void Run() = 0;
+
+  uint16_t m_interval;
+
+  /// Expiration time, milli-seconds after the chore before it in
+  /// the list.
+  uint16_t m_delta;
+
+  /// Table index of the next chore in the list.
+  uint8_t m_next;
+
+  /// Table index of this chore, NIL if not scheduled.
+  uint8_t m_slot;
+
+  // NON_COPYABLE
+  CompactChore (const CompactChore &);
+  const CompactChore & operator= (const CompactChore &);
+};
+
+
+// ----------------------------------------------------------------------------
+/** Compact scheduler.
+ *
+ * This scheduler runs CompactChores, for boards that run many
+ * small chores in little RAM.  Chores are kept in a table of
+ * SCHEDULER_COMPACT_CHORES entries and linked by table index in a
+ * list sorted by expiration time.  Each chore stores its
+ * expiration time as the delay after the chore before it, so the
+ * times fit 16 bits and only the time of the list head is kept in
+ * full.
+ *
+ * Chores are dispatched and rescheduled as by Scheduler, without
+ * drift.  Inserting a chore walks the list, so this scheduler is
+ * best for tens of chores, not thousands.
+ *
+ * The compact scheduler is a SchedulerChore, so it can run under
+ * a Scheduler.
+ *
+ * Example:
+\code
+class Blink : public CompactChore { ... };
+
+CompactScheduler  the_scheduler;
+Blink  blink (250);
+
+the_scheduler.Schedule (& blink);
+for (;;)
+  {
+    the_scheduler.RunScheduler();
+  }
+\endcode
+ */
+
+class CompactScheduler
+  : public SchedulerChore
+{
+public:
+  CompactScheduler ();
+  CompactScheduler (uint32_t inter);
+  virtual ~CompactScheduler();
+
+  void RunScheduler ();
+  int Schedule (CompactChore * chore);
+  int AbortChore (CompactChore * chore);
+  void AbortAllChores ();
+
+
+private:
+  friend class CompactChore;
+
+  virtual void Run() { RunScheduler(); }
+
+  void Register ();
+  void Insert (CompactChore * chore, int32_t offset);
+  void Unlink (CompactChore * chore);
+  void AdvanceTo (uint32_t now);
+
+  /// Chore at each index, 0 if free.
+  CompactChore * m_table[SCHEDULER_COMPACT_CHORES];
+
+  /// Index of first chore to expire, NIL if none.
+  uint8_t m_head;
+
+  /// Time the head's delta is counted from.
+  uint32_t m_listTime;
+
+  /// Other compact schedulers, so a chore can find its own.
+  CompactScheduler * m_nextScheduler;
+  static CompactScheduler * s_schedulers;
+
+  // NON_COPYABLE
+  CompactScheduler (const CompactScheduler &);
+  const CompactScheduler & operator= (const CompactScheduler &);
+};
+
+#endif
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
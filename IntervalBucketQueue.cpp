@@ -0,0 +1,327 @@
+/*********************************************************************
+  IntervalBucketQueue.cpp - per period queue policy for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "IntervalBucketQueue.h"
+
+#if defined (SCHEDULER_INTERVAL_QUEUE)
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * An empty queue is created.
+ */
+
+IntervalBucketQueue::
+IntervalBucketQueue()
+  : m_heapSize (0),
+    m_order (0)
+{
+  for (uint8_t b = 0; b < BUCKETS; ++b)
+    {
+      m_interval[b] = 0;
+      m_first[b] = 0;
+    }
+}
+
+
+// ------------------------------------------------------------------
+/** Insert chore into its bucket.
+ *
+ * The chore is added at the end of the bucket for its interval,
+ * unless it expires before the last chore there, in which case
+ * it is sorted into place from the end, after any chores that
+ * expire at the same time.
+ */
+
+void IntervalBucketQueue::
+Insert (SchedulerChore * chore)
+{
+  uint8_t b = FindBucket (Interval (chore));
+  SchedulerChore * first = m_first[b];
+
+  Order (chore) = m_order++;
+
+  if (first == 0)
+    {
+      Next (chore) = chore;
+      Prev (chore) = chore;
+      m_first[b] = chore;
+
+      // add bucket to heap
+      m_heap[m_heapSize] = b;
+      m_pos[b] = m_heapSize;
+      HeapUp (m_heapSize++);
+      return;
+    }
+
+  // Find the last chore that expires no later than the new one,
+  // searching from the end since the chore is usually last.
+  SchedulerChore * ptr = Prev (first);
+  while (*chore < *ptr)
+    {
+      if (ptr == first)
+        {
+          // new head of bucket
+          LinkBefore (chore, first);
+          m_first[b] = chore;
+          HeapUp (m_pos[b]);
+          return;
+        }
+
+      ptr = Prev (ptr);
+    }
+
+  LinkBefore (chore, Next (ptr));
+}
+
+
+// ------------------------------------------------------------------
+/** Remove chore from its bucket.
+ *
+ */
+
+void IntervalBucketQueue::
+Remove (SchedulerChore * chore)
+{
+  for (uint8_t b = 0; b < BUCKETS; ++b)
+    {
+      if (m_first[b] != chore)
+        {
+          continue;
+        }
+
+      // removing head of bucket
+      if (Next (chore) == chore)
+        {
+          m_first[b] = 0;
+          HeapRemove (b);
+        }
+      else
+        {
+          m_first[b] = Next (chore);
+          Unlink (chore);
+          HeapDown (m_pos[b]);
+          return;
+        }
+
+      break;
+    } // end for
+
+  Unlink (chore);
+}
+
+
+// ------------------------------------------------------------------
+/** Get chore that expires first.
+ *
+ */
+
+SchedulerChore * IntervalBucketQueue::
+Head ()
+{
+  return (m_heapSize == 0) ? 0 : m_first[m_heap[0]];
+}
+
+
+// ------------------------------------------------------------------
+/** Empty all buckets.
+ *
+ * Each chore is detached from its scheduler.
+ */
+
+void IntervalBucketQueue::
+Clear ()
+{
+  for (uint8_t b = 0; b < BUCKETS; ++b)
+    {
+      SchedulerChore * first = m_first[b];
+      if (first != 0)
+        {
+          SchedulerChore * ptr = first;
+          do
+            {
+              SchedulerChore * next = Next (ptr);
+              Detach (ptr);
+              ptr = next;
+            }
+          while (ptr != first);
+        }
+
+      m_interval[b] = 0;
+      m_first[b] = 0;
+    }
+
+  m_heapSize = 0;
+}
+
+
+// ------------------------------------------------------------------
+/** Find bucket for an interval.
+ *
+ * The bucket already holding the interval is used, otherwise an
+ * empty bucket is assigned to it.  If all buckets are in use, the
+ * mixed bucket is used.
+ *
+ * @param[in] inter - chore interval, milli-seconds
+ */
+
+uint8_t IntervalBucketQueue::
+FindBucket (uint32_t inter)
+{
+  uint8_t empty = MIXED;
+
+  if (inter == 0)
+    {
+      return (MIXED); // triggered event chore
+    }
+
+  for (uint8_t b = 0; b < MIXED; ++b)
+    {
+      if (m_first[b] == 0)
+        {
+          if (empty == MIXED)
+            {
+              empty = b;
+            }
+        }
+      else if (m_interval[b] == inter)
+        {
+          return (b);
+        }
+    } // end for
+
+  m_interval[empty] = inter;
+  return (empty);
+}
+
+
+// ------------------------------------------------------------------
+/** Compare bucket heads.
+ *
+ * @return true if the head of bucket a expires before the head
+ * of bucket b, or at the same time and was inserted first.
+ */
+
+bool IntervalBucketQueue::
+Earlier (uint8_t a, uint8_t b) const
+{
+  SchedulerChore * ca = m_first[a];
+  SchedulerChore * cb = m_first[b];
+
+  if (*ca == *cb)
+    {
+      return (int16_t (Order (ca) - Order (cb)) < 0);
+    }
+
+  return (*ca < *cb);
+}
+
+
+// ------------------------------------------------------------------
+/** Move heap entry toward the root.
+ *
+ */
+
+void IntervalBucketQueue::
+HeapUp (uint8_t pos)
+{
+  while (pos > 0)
+    {
+      uint8_t parent = (pos - 1) / 2;
+      if (! Earlier (m_heap[pos], m_heap[parent]))
+        {
+          break;
+        }
+
+      uint8_t tmp = m_heap[pos];
+      m_heap[pos] = m_heap[parent];
+      m_heap[parent] = tmp;
+      m_pos[m_heap[pos]] = pos;
+      m_pos[m_heap[parent]] = parent;
+
+      pos = parent;
+    }
+}
+
+
+// ------------------------------------------------------------------
+/** Move heap entry toward the leaves.
+ *
+ */
+
+void IntervalBucketQueue::
+HeapDown (uint8_t pos)
+{
+  while (1)
+    {
+      uint8_t child = 2 * pos + 1;
+      if (child >= m_heapSize)
+        {
+          break;
+        }
+
+      if (child + 1 < m_heapSize && Earlier (m_heap[child + 1], m_heap[child]))
+        {
+          ++child;
+        }
+
+      if (! Earlier (m_heap[child], m_heap[pos]))
+        {
+          break;
+        }
+
+      uint8_t tmp = m_heap[pos];
+      m_heap[pos] = m_heap[child];
+      m_heap[child] = tmp;
+      m_pos[m_heap[pos]] = pos;
+      m_pos[m_heap[child]] = child;
+
+      pos = child;
+    }
+}
+
+
+// ------------------------------------------------------------------
+/** Remove bucket from heap.
+ *
+ */
+
+void IntervalBucketQueue::
+HeapRemove (uint8_t bucket)
+{
+  uint8_t pos = m_pos[bucket];
+  uint8_t last = m_heap[--m_heapSize];
+
+  if (pos < m_heapSize)
+    {
+      m_heap[pos] = last;
+      m_pos[last] = pos;
+      HeapUp (pos);
+      HeapDown (m_pos[last]);
+    }
+}
+
+#endif	// SCHEDULER_INTERVAL_QUEUE
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,106 @@
+/*********************************************************************
+  IntervalBucketQueue.h - per period queue policy for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (IntervalBucketQueue_H_)
+#define IntervalBucketQueue_H_
+
+#include <Scheduler.h>
+
+#if defined (SCHEDULER_INTERVAL_QUEUE)
+
+// ----------------------------------------------------------------------------
+/** Interval bucket queue.
+ *
+ * This scheduler queue is for chore populations that share a few
+ * periods, such as 10, 100 and 1000 msec.  Chores are grouped by
+ * interval into buckets.  Chores with the same interval are
+ * rescheduled in the order they expire, so each bucket is a FIFO
+ * and a chore is inserted by adding it to the end of its bucket.
+ * A small heap of the bucket heads finds the next chore.
+ *
+ * Buckets are assigned to intervals as chores arrive and freed
+ * when they empty.  When all SCHEDULER_INTERVAL_BUCKETS buckets
+ * are in use, chores with other intervals share one extra bucket
+ * that is kept sorted.  A chore that does not expire after the
+ * others in its bucket, such as a triggered chore, is also sorted
+ * into place.
+ *
+ * Each chore is stamped with its insertion order, so chores in
+ * different buckets that expire at the same time are returned in
+ * the order they were inserted.  The order is kept as long as
+ * fewer than 32768 chores are inserted between them.  The queue
+ * is only built when SCHEDULER_INTERVAL_QUEUE is defined in
+ * SchedulerConfig.h.
+ *
+ * Example:
+\code
+IntervalBucketQueue  the_queue;
+
+the_scheduler.Queue (& the_queue);
+\endcode
+ */
+
+class IntervalBucketQueue : public SchedulerQueue
+{
+public:
+  IntervalBucketQueue ();
+  virtual ~IntervalBucketQueue() { }
+
+  virtual void Insert (SchedulerChore * chore);
+  virtual void Remove (SchedulerChore * chore);
+  virtual SchedulerChore * Head ();
+  virtual void Clear ();
+
+
+private:
+  enum { MIXED = SCHEDULER_INTERVAL_BUCKETS,
+         BUCKETS = SCHEDULER_INTERVAL_BUCKETS + 1 };
+
+  uint8_t FindBucket (uint32_t inter);
+  bool Earlier (uint8_t a, uint8_t b) const;
+  void HeapUp (uint8_t pos);
+  void HeapDown (uint8_t pos);
+  void HeapRemove (uint8_t bucket);
+
+  /// Interval of each bucket, last is mixed.
+  uint32_t m_interval[BUCKETS];
+
+  /// First chore of each bucket, in circular lists.
+  SchedulerChore * m_first[BUCKETS];
+
+  /// Heap of non-empty buckets, earliest head first.
+  uint8_t m_heap[BUCKETS];
+
+  /// Heap position of each bucket.
+  uint8_t m_pos[BUCKETS];
+  uint8_t m_heapSize;
+
+  /// Order stamp of the next chore inserted.
+  uint16_t m_order;
+};
+
+#endif	// SCHEDULER_INTERVAL_QUEUE
+
+#endif	// IntervalBucketQueue_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,91 @@
+/*********************************************************************
+  LEDflasher.cpp - LED flasher batch for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+// LEDflasher.h uses the Arduino pin functions
+#include "WProgram.h"
+
+#include "LEDflasher.h"
+
+
+#if defined (SCHEDULER_BATCHES)
+// ----------------------------------------------------------------------------
+/** Toggle a set of LED flashers.
+ *
+ * The new level of each LED is collected in a mask for its port,
+ * then each port is written once.
+ *
+ * @param[in] chores - LED flashers to toggle
+ * @param[in] count - number of chores
+ */
+
+void LEDflasherBatch::
+RunBatch (SchedulerChore * const * chores, uint8_t count)
+{
+  uint8_t ports[SCHEDULER_LED_PORTS];
+  uint8_t masks[SCHEDULER_LED_PORTS];
+  uint8_t levels[SCHEDULER_LED_PORTS];
+  uint8_t used = 0;
+
+  for (uint8_t i = 0; i < count; ++i)
+    {
+      LEDflasher * led = static_cast < LEDflasher * > (chores[i]);
+      uint8_t port;
+      uint8_t bit = LEDPort::PinToPort (led->m_pin, port);
+
+      uint8_t p = 0;
+      while (p < used && ports[p] != port)
+        {
+          ++p;
+        }
+
+      if (bit == 0 || p == SCHEDULER_LED_PORTS)
+        {
+          // no port to collect it in
+          led->Toggle();
+          continue;
+        }
+
+      if (p == used)
+        {
+          ports[p] = port;
+          masks[p] = 0;
+          levels[p] = 0;
+          ++used;
+        }
+
+      led->m_state ^= 1; // toggle state
+      masks[p] |= bit;
+      if (led->m_state)
+        {
+          levels[p] |= bit;
+        }
+    }
+
+  for (uint8_t p = 0; p < used; ++p)
+    {
+      LEDPort::WritePort (0, ports[p], masks[p], levels[p]);
+    }
+}
+#endif
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
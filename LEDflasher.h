@@ -22,37 +22,79 @@
 #define LEDflasher_H_
 
 #include <Scheduler.h>
+#include <MultiLEDflasher.h>
 
 // ------------------------------------------------------------------
 /** LED Flasher chore.
  *
  * This class is a LED flasher chore. The half-cycle time is
  * specified when an object is created.
+ *
+ * Flashers that blink together can share a LEDflasherBatch, so
+ * the scheduler toggles all of them in one dispatch.  For many
+ * LEDs, a MultiLEDflasher writes each port once.  Blink codes and
+ * dimming are done by a PatternSequencer.
  */
 
 class LEDflasher
   : public SchedulerChore
 {
 public:
-  LEDflasher(int pin)
+  LEDflasher(uint8_t pin)
     : m_pin(pin),
       m_state(0)
   { 
     pinMode (m_pin, OUTPUT);
   }
+
+  /// Toggle the LED.
+  void Toggle()
+  {
+    m_state ^= 1; // toggle state  
+    digitalWrite (m_pin, m_state);
+  }
   
   
 private:
   virtual void Run()
   {
-    m_state ^= 1; // toggle state  
-    digitalWrite (m_pin, m_state);
+    Toggle();
   }
   
+  friend class LEDflasherBatch;
   
-  int m_pin : 4;
-  int m_state : 1
+  uint8_t m_pin;
+  uint8_t m_state;
+};
+
+
+#if defined (SCHEDULER_BATCHES)
+// ------------------------------------------------------------------
+/** LED flasher batch.
+ *
+ * This class toggles all LED flashers that expire together with
+ * a single dispatch.  The LEDs are grouped by port and each port
+ * is written once, see LEDPort::WritePort().  LEDs on more than
+ * SCHEDULER_LED_PORTS ports in one dispatch are written one at a
+ * time.  Only LEDflasher chores may be added to this batch.
+ *
+ * Example:
+\code
+LEDflasherBatch flashers;
+LEDflasher led1 (13), led2 (12);
+
+led1.Batch (& flashers);
+led2.Batch (& flashers);
+\endcode
+ */
+
+class LEDflasherBatch
+  : public ChoreBatch
+{
+public:
+  virtual void RunBatch (SchedulerChore * const * chores, uint8_t count);
 };
+#endif
 
 #endif
 
@@ -0,0 +1,237 @@
+/*********************************************************************
+  MultiLEDflasher.cpp - port wide LED flasher for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "MultiLEDflasher.h"
+
+#include "WProgram.h"
+
+#if defined (__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+
+// ------------------------------------------------------------------
+/** Map pin to port and bit.
+ *
+ * @param[in] pin - pin number
+ * @param[out] port - port number
+ * @return bit mask of the pin in the port, or 0 for no pin.
+ */
+
+uint8_t LEDPort::
+PinToPort (uint8_t pin, uint8_t & port)
+{
+#if defined (__AVR__) && defined (digitalPinToPort)
+  port = digitalPinToPort (pin);
+  return (port == NOT_A_PIN) ? 0 : digitalPinToBitMask (pin);
+#else
+  port = pin >> 3;
+  return (1 << (pin & 7));
+#endif
+}
+
+
+// ----------------------------------------------------------------------------
+/** Write pins of a port.
+ *
+ * The port is written through the backend if one is given.
+ * Otherwise, on AVR the port register is updated with interrupts
+ * disabled, so pins of the port outside the mask can be changed
+ * by interrupt handlers.  On other targets each pin in the mask
+ * is written with digitalWrite().
+ *
+ * @param[in] backend - port backend, or 0 for the default
+ * @param[in] port - port number
+ * @param[in] mask - pins to write
+ * @param[in] level - new output levels, for pins in mask
+ */
+
+void LEDPort::
+WritePort (LEDPort * backend, uint8_t port, uint8_t mask, uint8_t level)
+{
+  if (backend != 0)
+    {
+      backend->Write (port, mask, level);
+      return;
+    }
+
+#if defined (__AVR__) && defined (portOutputRegister)
+  volatile uint8_t * out = portOutputRegister (port);
+  uint8_t sreg = SREG;
+
+  cli();
+  *out = (*out & ~mask) | level;
+  SREG = sreg;
+#else
+  for (uint8_t bit = 0; bit < 8; ++bit)
+    {
+      if (mask & (1 << bit))
+        {
+          digitalWrite ((port << 3) + bit, (level >> bit) & 1);
+        }
+    }
+#endif
+}
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * A flasher with no LEDs is created.
+ *
+ * @param[in] inter - half-cycle time, milli-seconds
+ * @param[in] backend - port backend, or 0 for the default
+ */
+
+MultiLEDflasher::
+MultiLEDflasher (uint32_t inter, LEDPort * backend)
+  : SchedulerChore (inter),
+    m_backend (backend)
+{
+  for (uint8_t i = 0; i < SCHEDULER_LED_PORTS; ++i)
+    {
+      m_ports[i].m_mask = 0;
+      m_ports[i].m_level = 0;
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Add LED to flasher.
+ *
+ * The pin is made an output. The LED starts off, and is turned on
+ * the next time the flasher runs.
+ *
+ * @param[in] pin - pin the LED is on
+ * @retval 0 - LED added
+ * @retval -1 - not a pin, or all ports are in use
+ */
+
+int MultiLEDflasher::
+Add (uint8_t pin)
+{
+  uint8_t port;
+  uint8_t bit = LEDPort::PinToPort (pin, port);
+  if (bit == 0)
+    {
+      return (-1);
+    }
+
+  PortPins * pp = FindPort (port);
+  if (pp == 0)
+    {
+      return (-1);
+    }
+
+  pp->m_port = port;
+  pp->m_mask |= bit;
+  pp->m_level &= ~bit;
+
+  pinMode (pin, OUTPUT);
+
+  return (0);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Remove LED from flasher.
+ *
+ * The LED is left in its current state.
+ *
+ * @param[in] pin - pin the LED is on
+ */
+
+void MultiLEDflasher::
+Remove (uint8_t pin)
+{
+  uint8_t port;
+  uint8_t bit = LEDPort::PinToPort (pin, port);
+
+  for (uint8_t i = 0; i < SCHEDULER_LED_PORTS; ++i)
+    {
+      if (m_ports[i].m_mask != 0 && m_ports[i].m_port == port)
+        {
+          m_ports[i].m_mask &= ~bit;
+          m_ports[i].m_level &= ~bit;
+          break;
+        }
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Toggle all LEDs.
+ *
+ * Each port is written once, see LEDPort::WritePort().
+ */
+
+void MultiLEDflasher::
+Toggle()
+{
+  for (uint8_t i = 0; i < SCHEDULER_LED_PORTS; ++i)
+    {
+      PortPins & pp = m_ports[i];
+      if (pp.m_mask == 0)
+        {
+          continue;
+        }
+
+      pp.m_level ^= pp.m_mask; // toggle state
+      LEDPort::WritePort (m_backend, pp.m_port, pp.m_mask, pp.m_level);
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Find entry for a port.
+ *
+ * @param[in] port - port number
+ * @return entry for the port, a free entry, or 0 if all entries
+ * are used by other ports.
+ */
+
+MultiLEDflasher::PortPins * MultiLEDflasher::
+FindPort (uint8_t port)
+{
+  PortPins * free_pp = 0;
+
+  for (uint8_t i = 0; i < SCHEDULER_LED_PORTS; ++i)
+    {
+      if (m_ports[i].m_mask == 0)
+        {
+          if (free_pp == 0)
+            {
+              free_pp = & m_ports[i];
+            }
+        }
+      else if (m_ports[i].m_port == port)
+        {
+          return (& m_ports[i]);
+        }
+    }
+
+  return (free_pp);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
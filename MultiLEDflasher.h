@@ -0,0 +1,121 @@
+/*********************************************************************
+  MultiLEDflasher.h - port wide LED flasher for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (MultiLEDflasher_H_)
+#define MultiLEDflasher_H_
+
+#include <Scheduler.h>
+
+// ------------------------------------------------------------------
+/** LED port backend.
+ *
+ * This class is the abstract base class for writing LED outputs
+ * a port at a time.  A port is a group of up to eight pins that
+ * are written together, such as an AVR I/O port or a shift
+ * register.  A backend lets the MultiLEDflasher drive outputs
+ * that are not AVR ports, and run on a host.
+ *
+ * The static methods map pins to ports and write a port through
+ * a backend, or directly when there is none, for any class that
+ * drives LEDs a port at a time.
+ */
+
+class LEDPort
+{
+public:
+  virtual ~LEDPort() { }
+
+  static uint8_t PinToPort (uint8_t pin, uint8_t & port);
+  static void WritePort (LEDPort * backend, uint8_t port,
+                         uint8_t mask, uint8_t level);
+
+  /** Write pins of a port.
+   *
+   * @param[in] port - port number
+   * @param[in] mask - pins to write
+   * @param[in] level - new output levels, for pins in mask
+   */
+  virtual void Write (uint8_t port, uint8_t mask, uint8_t level) = 0;
+};
+
+
+// ------------------------------------------------------------------
+/** Multiple LED flasher chore.
+ *
+ * This class flashes a set of LEDs together. The pins are kept
+ * as a bit mask for each port, and all LEDs on a port are
+ * toggled by one write to the port, instead of one digitalWrite()
+ * call per LED.  The half-cycle time is specified when an object
+ * is created.
+ *
+ * On AVR the port output registers are written directly unless a
+ * backend is given.  On other targets, the LEDs are written
+ * through the backend, or with digitalWrite() if there is no
+ * backend.  Pins outside AVR ports are numbered eight to a port.
+ *
+ * LEDs on up to SCHEDULER_LED_PORTS ports can be added.
+ *
+ * Example:
+\code
+MultiLEDflasher  status (500);
+
+status.Add (10);
+status.Add (11);
+status.Add (12);
+the_scheduler.Schedule (& status);
+\endcode
+ */
+
+class MultiLEDflasher
+  : public SchedulerChore
+{
+public:
+  MultiLEDflasher (uint32_t inter, LEDPort * backend = 0);
+  virtual ~MultiLEDflasher() { }
+
+  int Add (uint8_t pin);
+  void Remove (uint8_t pin);
+
+  /// Toggle all LEDs.
+  void Toggle();
+
+
+private:
+  virtual void Run() { Toggle(); }
+
+  struct PortPins
+  {
+    uint8_t m_port;
+    uint8_t m_mask;    // pins flashed
+    uint8_t m_level;   // current output level of pins
+  };
+
+  PortPins * FindPort (uint8_t port);
+
+  LEDPort * m_backend;
+  PortPins m_ports[SCHEDULER_LED_PORTS];
+};
+
+#endif
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,233 @@
+/*********************************************************************
+  PatternSequencer.cpp - LED pattern and PWM sequencer for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "PatternSequencer.h"
+
+#include "WProgram.h"
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * A sequencer with no channels is created.
+ */
+
+PatternSequencer::
+PatternSequencer ()
+  : SchedulerChore (SCHEDULER_PWM_FRAME),
+    m_frameStart (0)
+{
+  for (uint8_t i = 0; i < SCHEDULER_PWM_CHANNELS; ++i)
+    {
+      m_chan[i].m_count = 0;
+      m_chan[i].m_level = 0;
+      m_chan[i].m_on = 0;
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Set pattern of a channel.
+ *
+ * The pattern starts at its first step the next time the
+ * sequencer runs.  The step table is not
+ * copied, and must stay valid while it is in use.  If the
+ * sequencer is scheduled, it runs at once to apply the change.
+ *
+ * @param[in] chan - channel number
+ * @param[in] pin - pin the LED is on
+ * @param[in] steps - pattern steps
+ * @param[in] count - number of steps, 0 to turn channel off
+ * @retval 0 - pattern set
+ * @retval -1 - no such channel
+ */
+
+int PatternSequencer::
+Channel (uint8_t chan, uint8_t pin,
+         const PatternStep * steps, uint8_t count)
+{
+  if (chan >= SCHEDULER_PWM_CHANNELS)
+    {
+      return (-1);
+    }
+
+  ChannelState & ch = m_chan[chan];
+
+  if (ch.m_count != 0 && ch.m_pin != pin)
+    {
+      digitalWrite (ch.m_pin, LOW);
+    }
+
+  ch.m_steps = steps;
+  ch.m_count = count;
+  ch.m_step = 0;
+  ch.m_stepStart = 0;
+  ch.m_start = 1;
+  ch.m_pin = pin;
+  ch.m_from = 0;
+  ch.m_level = 0;
+  ch.m_on = 0;
+
+  pinMode (pin, OUTPUT);
+  digitalWrite (pin, LOW);
+
+  if (IsScheduled())
+    {
+      Trigger();
+    }
+
+  return (0);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Move channel to the step that is current.
+ *
+ * Steps that ended are skipped, and the brightness of the step
+ * is computed.  Steps with no time are passed at once, unless
+ * all steps have no time, when the channel stays on one.
+ *
+ * @param[in] ch - channel
+ * @param[in] now - current time
+ */
+
+void PatternSequencer::
+Advance (ChannelState & ch, uint32_t now)
+{
+  const PatternStep * step = & ch.m_steps[ch.m_step];
+  uint8_t empty = 0; // zero length steps passed in a row
+
+  while (now - ch.m_stepStart >= step->m_time && empty < ch.m_count)
+    {
+      ch.m_from = step->m_level;
+      ch.m_stepStart += step->m_time;
+      empty = (step->m_time == 0) ? empty + 1 : 0;
+      if (++ch.m_step == ch.m_count)
+        {
+          ch.m_step = 0;
+        }
+
+      step = & ch.m_steps[ch.m_step];
+    }
+
+  if (step->m_fade && step->m_time != 0)
+    {
+      int32_t span = (int16_t) step->m_level - ch.m_from;
+      ch.m_level = ch.m_from + span * (int32_t) (now - ch.m_stepStart) / step->m_time;
+    }
+  else
+    {
+      ch.m_level = step->m_level;
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Update outputs.
+ *
+ * A PWM frame starts with all dimmed LEDs on, and each is turned
+ * off when its on time in the frame has passed.  The chore is
+ * set to run again at the next edge, step or frame, counted from
+ * now, so a late run does not make the next edge early.
+ */
+
+void PatternSequencer::
+Run()
+{
+  const uint8_t frame = SCHEDULER_PWM_FRAME;
+  uint32_t now = Parent()->Now();
+
+  // the scheduler runs a chore up to a milli-second early; count
+  // from the time it was due, so each run moves on to a new edge
+  if ((int32_t) (TargetTime() - now) > 0)
+    {
+      now = TargetTime();
+    }
+
+  if (now - m_frameStart >= frame)
+    {
+      m_frameStart = now; // start a new frame
+    }
+
+  uint8_t phase = now - m_frameStart;
+  uint32_t next = 0xffff;
+
+  for (uint8_t i = 0; i < SCHEDULER_PWM_CHANNELS; ++i)
+    {
+      ChannelState & ch = m_chan[i];
+      if (ch.m_count == 0)
+        {
+          continue;
+        }
+
+      if (ch.m_start)
+        {
+          ch.m_stepStart = now;
+          ch.m_start = 0;
+        }
+
+      Advance (ch, now);
+
+      // on time in frame, milli-seconds
+      uint8_t on_time = ((uint16_t) ch.m_level * frame + 128) >> 8;
+      uint8_t on = (phase < on_time);
+
+      if (on != ch.m_on)
+        {
+          ch.m_on = on;
+          digitalWrite (ch.m_pin, on ? HIGH : LOW);
+        }
+
+      // next transition of this channel: end of step, end of
+      // on time, or end of frame while dimmed or fading
+      const PatternStep & step = ch.m_steps[ch.m_step];
+      uint32_t wait = (step.m_time == 0) ? 0xffff
+        : ch.m_stepStart + step.m_time - now;
+      if (on && on_time < frame)
+        {
+          if (wait > (uint32_t) (on_time - phase))
+            {
+              wait = on_time - phase;
+            }
+        }
+      else if ((on_time > 0 && on_time < frame)
+               || (step.m_fade && step.m_time != 0))
+        {
+          if (wait > (uint32_t) (frame - phase))
+            {
+              wait = frame - phase;
+            }
+        }
+
+      if (wait < next)
+        {
+          next = wait;
+        }
+    }
+
+  // the scheduler adds the interval to the target time
+  TargetTime (now);
+  Interval (next ? next : 1);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,119 @@
+/*********************************************************************
+  PatternSequencer.h - LED pattern and PWM sequencer for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (PatternSequencer_H_)
+#define PatternSequencer_H_
+
+#include <Scheduler.h>
+
+// ------------------------------------------------------------------
+/** Pattern step.
+ *
+ * One step of a LED pattern.  The LED is held at the level for
+ * the time of the step, or ramps to the level from the level of
+ * the previous step when fade is set.  A step with no time sets
+ * the level at once and moves on.
+ */
+
+struct PatternStep
+{
+  uint8_t m_level;   // brightness, 0 (off) to 255 (on)
+  uint8_t m_fade;    // non-zero to ramp to level
+  uint16_t m_time;   // step length, milli-seconds
+};
+
+
+// ------------------------------------------------------------------
+/** LED pattern sequencer chore.
+ *
+ * This chore plays a looping pattern of steps on each of up to
+ * SCHEDULER_PWM_CHANNELS LEDs, with software PWM for levels
+ * between off and on.  Blink codes, brightness ramps and breathing
+ * are all tables of steps.
+ *
+ * One chore serves all channels.  Each time it runs, it updates
+ * the outputs and sets its interval to the time of the next
+ * transition of any channel, so it only wakes for the edges.
+ * While all LEDs are fully on or off, it sleeps until the next
+ * step.  While a LED is dimmed or fading, it wakes for the PWM
+ * edges, which are SCHEDULER_PWM_FRAME milli-seconds apart.
+ *
+ * The edges fall on milli-second ticks, so brightness has only
+ * SCHEDULER_PWM_FRAME + 1 distinct levels, eleven with the default
+ * 10 milli-second frame, and the step levels of 0 to 255 are
+ * rounded to the nearest one.  A longer frame gives more levels,
+ * but frames longer than about 20 milli-seconds flicker.
+ *
+ * Example:
+\code
+const PatternStep breathe[] = { { 255, 1, 1500 }, { 0, 1, 1500 } };
+const PatternStep sos[] = { { 255, 0, 150 }, { 0, 0, 150 },
+                            { 255, 0, 150 }, { 0, 0, 150 },
+                            { 255, 0, 150 }, { 0, 0, 600 } };
+PatternSequencer  leds;
+
+leds.Channel (0, 9, breathe, 2);
+leds.Channel (1, 13, sos, 6);
+the_scheduler.Schedule (& leds);
+\endcode
+ */
+
+class PatternSequencer
+  : public SchedulerChore
+{
+public:
+  PatternSequencer ();
+  virtual ~PatternSequencer() { }
+
+  int Channel (uint8_t chan, uint8_t pin,
+               const PatternStep * steps, uint8_t count);
+
+  /// Return current brightness of a channel.
+  uint8_t Brightness (uint8_t chan) const { return m_chan[chan].m_level; }
+
+
+private:
+  virtual void Run();
+
+  struct ChannelState
+  {
+    const PatternStep * m_steps;
+    uint32_t m_stepStart;   // time current step started
+    uint8_t m_count;        // number of steps, 0 if unused
+    uint8_t m_step;         // current step
+    uint8_t m_pin;
+    uint8_t m_from;         // level at start of current step
+    uint8_t m_level;        // current brightness
+    uint8_t m_on;           // current output
+    uint8_t m_start;        // non-zero until first run
+  };
+
+  void Advance (ChannelState & ch, uint32_t now);
+
+  ChannelState m_chan[SCHEDULER_PWM_CHANNELS];
+  uint32_t m_frameStart;
+};
+
+#endif
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,88 @@
+/*********************************************************************
+  ResumableChore.cpp - long chore that can yield to others.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "ResumableChore.h"
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * @param[in] inter - scheduling interval in milli-seconds
+ */
+
+ResumableChore::
+ResumableChore (uint32_t inter)
+  : SchedulerChore (inter),
+    m_periodTarget (0),
+    m_resumeTarget (0),
+    m_resuming (false)
+{
+}
+
+
+// ----------------------------------------------------------------------------
+/** Run chore.
+ *
+ * The work is processed.  If it is not done, the chore is
+ * triggered to continue, which puts it behind the chores that
+ * are already due.  In a nested scheduler it is continued two
+ * milli-seconds later instead, so the nested scheduler returns
+ * and the chores due in its parents can run.  When the work is
+ * done after being continued, the expiration time it was started
+ * for is put back, so the scheduler reschedules it one interval
+ * from there.
+ *
+ * The work is only continued if the chore runs at the time it
+ * was put off to.  A run at any other time means the chore was
+ * aborted and scheduled again, so the work is started afresh
+ * with Restart().
+ */
+
+void ResumableChore::
+Run ()
+{
+  bool resuming = m_resuming && TargetTime() == m_resumeTarget;
+
+  m_resuming = false;
+  if (! resuming)
+    {
+      m_periodTarget = TargetTime();
+      Restart();
+    }
+
+  if (Process())
+    {
+      if (resuming)
+        {
+          TargetTime (m_periodTarget);
+        }
+
+      return;
+    }
+
+  Parent()->Trigger (this, Parent()->IsNested() ? 2 : 0);
+  m_resumeTarget = TargetTime();
+  m_resuming = true;
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,125 @@
+/*********************************************************************
+  ResumableChore.h - long chore that can yield to others.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (ResumableChore_H_)
+#define ResumableChore_H_
+
+#include <Scheduler.h>
+
+// ----------------------------------------------------------------------------
+/** Resumable chore.
+ *
+ * This class is the base class for chores that do a long piece of
+ * work, such as processing a large buffer, in steps.  Process()
+ * does some of the work and returns false if there is more to do,
+ * usually when ShouldYield() says a chore of higher priority is
+ * due.  The chore is then triggered to continue, so the chores
+ * that are due run first and the work is picked up where it left
+ * off.  The derived class keeps its own place in the work, and
+ * resets it in Restart(), which is called before each new piece
+ * of work is started.
+ *
+ * Once Process() returns true, the chore is rescheduled from the
+ * time the work was started, so yielding does not shift its
+ * period.  If the chore is aborted while the work is put off,
+ * and scheduled again, Restart() is called and the work is
+ * started afresh.
+ *
+ * ShouldYield() only finds chores of higher priority when
+ * SCHEDULER_PRIORITY is defined in SchedulerConfig.h.
+ *
+ * Example:
+\code
+class checksum_chore : public ResumableChore
+{
+public:
+  checksum_chore() : ResumableChore (1000), m_pos (0), m_sum (0) { }
+
+private:
+  virtual void Restart()
+  {
+    m_pos = 0;
+    m_sum = 0;
+  }
+
+  virtual bool Process()
+  {
+    for ( ; m_pos < BUFFER_SIZE; ++m_pos)
+      {
+        if ((m_pos & 63) == 0 && ShouldYield())
+          {
+            return (false);
+          }
+
+        m_sum += buffer[m_pos];
+      }
+
+    return (true);
+  }
+
+  uint16_t m_pos;
+  uint8_t m_sum;
+};
+\endcode
+ */
+
+class ResumableChore
+  : public SchedulerChore
+{
+public:
+  ResumableChore (uint32_t inter);
+
+  /// Return true if the work was put off and is to be continued.
+  bool IsResuming() const
+  { return m_resuming && IsQueued() && TargetTime() == m_resumeTarget; }
+
+
+protected:
+  /** Start new work.  This method is called before Process()
+   * when a new piece of work is started, but not when the work is
+   * continued.  The derived class resets its place in the work.
+   */
+  virtual void Restart () { }
+
+  /** Procedure to run.  This method is the do-it function for
+   * this chore.
+   *
+   * @return true when the work is done, false to be continued.
+   */
+  virtual bool Process () = 0;
+
+
+private:
+  virtual void Run ();
+
+  /// Time the work was started for, milli-seconds.
+  uint32_t m_periodTarget;
+
+  /// Time the work was put off to, milli-seconds.
+  uint32_t m_resumeTarget;
+  bool m_resuming;
+};
+
+#endif	// ResumableChore_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -19,9 +19,98 @@
 ***********************************************************************/
 
 #include "Scheduler.h"
+#include "SchedulerTrace.h"
+#include "SchedulerLog.h"
+#include "SchedulerWatchdog.h"
 #include "WProgram.h"
 
 
+namespace {
+
+// Read the micro-second clock, through the log when recording.
+inline uint32_t ReadMicros()
+{
+#if defined (SCHEDULER_RECORD)
+  return SchedulerLog::Micros (micros());
+#else
+  return micros();
+#endif
+}
+
+//
+// Saved state layout: "SS", a version byte, a chore count byte,
+// then for each chore its id byte and the remaining time and
+// interval as variable length numbers, seven bits per byte, low
+// bits first, with the top bit set while more bytes follow.  The
+// last byte is a check byte, so a blank or stale EEPROM is
+// rejected.
+//
+
+const uint8_t STATE_VERSION = 1;
+const uint8_t STATE_HEADER_SIZE = 4;
+
+
+// Write variable length number, return new position or 0 if full.
+uint16_t PutNumber (uint8_t * buf, uint16_t pos, uint16_t size, uint32_t val)
+{
+  do
+    {
+      if (pos >= size)
+        {
+          return (0);
+        }
+
+      uint8_t byte = val & 0x7f;
+      val >>= 7;
+      buf[pos++] = (val != 0) ? (byte | 0x80) : byte;
+    }
+  while (val != 0);
+
+  return (pos);
+}
+
+
+// Read variable length number, return new position or 0 if short.
+uint16_t GetNumber (const uint8_t * buf, uint16_t pos, uint16_t size, uint32_t & val)
+{
+  val = 0;
+  for (uint8_t shift = 0; shift < 32; shift += 7)
+    {
+      if (pos >= size)
+        {
+          return (0);
+        }
+
+      uint8_t byte = buf[pos++];
+      val |= (uint32_t) (byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0)
+        {
+          return (pos);
+        }
+    }
+
+  return (0);
+}
+
+
+// Check byte over a block.
+uint8_t StateCheck (const uint8_t * buf, uint16_t size)
+{
+  uint8_t sum = 0x5a;
+  for (uint16_t i = 0; i < size; ++i)
+    {
+      sum = (uint8_t) ((sum << 1) | (sum >> 7)) ^ buf[i];
+    }
+
+  return (sum);
+}
+
+} // end namespace
+
+
+uint32_t Scheduler::s_slept = 0;
+
+
 // -------------------------------------------------------
 /** Constructor.
  *
@@ -31,29 +120,111 @@
 
 Scheduler::
 Scheduler() 
+  : m_currentEpoch (0),
+    m_suspendTime (0),
+    m_suspended (false),
+    m_owner (0),
+    m_power (0)
 {
-  m_next = this;
-  m_prev = this;  
+  m_queue = & m_defaultQueue;
+
+  m_baseTime = Millis();
+
+#if defined (SCHEDULER_TRACE)
+  m_trace = 0;
+#endif
+
+#if defined (SCHEDULER_LOAD_STATS)
+  m_loadWindow = SCHEDULER_LOAD_WINDOW;
+  m_windowStart = ReadMicros();
+  m_busyTime = 0;
+  m_lastBusyTime = 0;
+  m_lastWindowTime = 0;
+  m_window = 0;
+#endif
+
+#if defined (SCHEDULER_ADAPTIVE)
+  m_lateAvg = 0;
+  m_adaptHigh = 10;
+  m_adaptLow = 2;
+  m_adaptLevel = 0;
+  m_adaptTime = 0;
+  m_adaptLate = 0xffff;
+# if defined (SCHEDULER_LOAD_STATS)
+  m_adaptLoad = 0xffff;
+# endif
+#endif
+}
 
-  m_baseTime = millis();
 
-  // schedule our timer wrap manager
-  Schedule (& m_timerWrap);
+// -------------------------------------------------------
+/** Constructor.
+ *
+ * A scheduler is created that can be scheduled as a chore in
+ * another scheduler. The interval is the rate, in
+ * milli-seconds, at which the parent scheduler will run this
+ * scheduler.
+ *
+ * @param[in] inter - scheduling interval in milli-seconds
+ */
 
+Scheduler::
+Scheduler (uint32_t inter)
+  : SchedulerChore (inter),
+    m_currentEpoch (0),
+    m_suspendTime (0),
+    m_suspended (false),
+    m_owner (0),
+    m_power (0)
+{
+  m_queue = & m_defaultQueue;
+
+  m_baseTime = Millis();
+
+#if defined (SCHEDULER_TRACE)
+  m_trace = 0;
+#endif
+
+#if defined (SCHEDULER_LOAD_STATS)
+  m_loadWindow = SCHEDULER_LOAD_WINDOW;
+  m_windowStart = ReadMicros();
+  m_busyTime = 0;
+  m_lastBusyTime = 0;
+  m_lastWindowTime = 0;
+  m_window = 0;
+#endif
+
+#if defined (SCHEDULER_ADAPTIVE)
+  m_lateAvg = 0;
+  m_adaptHigh = 10;
+  m_adaptLow = 2;
+  m_adaptLevel = 0;
+  m_adaptTime = 0;
+  m_adaptLate = 0xffff;
+# if defined (SCHEDULER_LOAD_STATS)
+  m_adaptLoad = 0xffff;
+# endif
+#endif
 }
 
 
 // ----------------------------------------------------------------------------
 /** Destructor.
  *
- * This method stops and cleans up a scheduler. 
+ * This method stops and cleans up a scheduler. Any chores still
+ * in the list are orphaned so they can be scheduled elsewhere.
  *
  */
 
 Scheduler::
 ~Scheduler()
 {
+  SchedulerChore * chore;
 
+  while ((chore = m_queue->Head()) != 0)
+    {
+      AbortChore (chore);
+    }
 }
 
 
@@ -62,36 +233,100 @@ Scheduler::
  *
  * This is the main method that runs the scheduler loop.  It
  * dispatches all chores that have expired. Chores are
- * automatically rescheduled.
+ * automatically rescheduled. Chores that depend on a chore that
+ * has run are triggered, so they are dispatched in this pass.
+ * Chores of a batch that expire together are run with one call
+ * to the batch.  When nothing is left to run and a power policy
+ * is set, the board sleeps until the next chore is due.
  * 
  */
 
 void Scheduler::
 RunScheduler ()
 {
+  if (m_suspended)
+    {
+      return;
+    }
+
+  UpdateLoad();
+
+#if defined (SCHEDULER_WATCHDOG)
+  SchedulerWatchdog::Kick();
+#endif
 
   // Check to see if there is something to run.
   // delta in milli-secs, signed
-  while (1)
+  SchedulerChore * chore;
+
+  while ((chore = m_queue->Head()) != 0)
     {
-      int32_t delta (this->m_next->m_targetTime - GetCurrentTime());
+      int32_t delta (chore->m_targetTime - GetCurrentTime());
       if (delta <= 1 )
         {
           // time to dispatch the chore
-          SchedulerChore * chore = this->m_next;
-          chore->Remove();
+          m_queue->Remove (chore);
           
           // Test for orphaned chore - do not run orphaned chore
-          if (chore->m_parent != 0)
+          if (! chore->IsScheduled())
+            {
+              continue;
+            }
+
+#if defined (SCHEDULER_BATCHES)
+          // Collect chores of the same batch that expire together
+          SchedulerChore * group[SCHEDULER_BATCH_SIZE];
+          uint8_t count = 0;
+
+          group[count++] = chore;
+          if (chore->m_batch != 0)
+            {
+              SchedulerChore * next;
+
+              while (count < SCHEDULER_BATCH_SIZE
+                     && (next = m_queue->Head()) != 0
+                     && next->m_batch == chore->m_batch
+                     && next->m_targetTime == chore->m_targetTime)
+                {
+                  m_queue->Remove (next);
+                  if (next->IsScheduled())
+                    {
+                      group[count++] = next;
+                    }
+                }
+            }
+#else
+          SchedulerChore * const * group = & chore;
+          const uint8_t count = 1;
+#endif
+
+          Adapt (-delta);
+
+          // Activate the chores.
+          Dispatch (group, count);
+
+          // immediately reschedule, keeping the group together
+          for (uint8_t i = 0; i < count; ++i)
             {
-              // Activate the chore.
-              chore->Run();
+              Reschedule (group[i], (i == 0) ? 0 : group[i - 1]);
+            }
 
-              Reschedule(chore); // immediately reschedule
+#if defined (SCHEDULER_DEPENDENCIES)
+          // release dependent chores
+          for (uint8_t i = 0; i < count; ++i)
+            {
+              Complete (group[i]);
             }
+#endif
         }
       else // no chores to dispatch
         {
+          if (m_power != 0)
+            {
+              // the clock may be stopped while asleep
+              s_slept += m_power->Sleep (delta - 1);
+            }
+
           break;
         }
     } // end while
@@ -104,6 +339,8 @@ RunScheduler ()
  * This method schedules a \e new chore. The chore's execution
  * time is set to its recurrence interval plus the current time,
  * so it will execute the specified number of seconds from now.
+ * An event chore (zero interval) is attached to this scheduler
+ * but does not run until triggered.
  * 
  * @param[in] chore - chore to schedule
  *
@@ -115,15 +352,32 @@ int Scheduler::
 Schedule (SchedulerChore * chore)
 {
   // Make sure chore is not active
-  if (chore->m_parent != 0)
+  if (chore->IsScheduled())
     {
       return -1;
     }
 
+  // drop links left from a queue that was cleared
+  chore->m_next = 0;
+  chore->m_prev = 0;
+
+  if (chore->m_interval == 0)
+    {
+      // event chore - attach, but wait for a trigger
+      chore->m_parent = this;
+      chore->m_epoch = m_currentEpoch;
+      TraceEvent (SchedulerTraceRecord::SCHEDULE, chore);
+      return (0);
+    }
+
   // calculate execution time
   chore->m_targetTime = GetCurrentTime() + chore->m_interval;
+#if defined (SCHEDULER_FRACTIONAL_PERIODS)
+  chore->m_fracAccum = 0;
+#endif
 
   Insert (chore);
+  TraceEvent (SchedulerTraceRecord::SCHEDULE, chore);
 
   return (0);
 }
@@ -136,251 +390,1448 @@ Schedule (SchedulerChore * chore)
  * chore's execution time is calculated by adding the recurrence
  * interval to the chore's last execution time.  In this way,
  * the chore's execution time does not slip due to system
- * delays.
+ * delays. The fractional part of the chore's period is
+ * accumulated, and a milli-second is added each time it adds up
+ * to a whole one. An event chore waits for its next trigger, and a
+ * chore that was triggered while running is already in the
+ * list.
  * 
  * @param[in] chore - chore to reschedule
+ * @param[in] after - chore rescheduled just before this one, or 0
  *
  * @retval 0 - chore reshceduled
  * @retval -1 - chore not attached to scheduler
  */
 
 int Scheduler::
-Reschedule (SchedulerChore * chore)
+Reschedule (SchedulerChore * chore, SchedulerChore * after)
 {
 
   // Make sure chore is  active
-  if (chore->m_parent == 0)
+  if (! chore->IsScheduled())
     {
+      // detach a chore orphaned while it ran
+      if (chore->m_parent == this)
+        {
+          chore->m_parent = 0;
+        }
+
       return -1;
     }
 
+  if (chore->m_interval == 0 || chore->IsQueued())
+    {
+      return (0);
+    }
+
   // calculate execution time
   chore->m_targetTime += chore->m_interval;
 
-  Insert (chore);
+#if defined (SCHEDULER_FRACTIONAL_PERIODS)
+  if (chore->m_fracNum != 0)
+    {
+      uint32_t accum = (uint32_t) chore->m_fracAccum + chore->m_fracNum;
+      if (accum >= chore->m_fracDen)
+        {
+          accum -= chore->m_fracDen;
+          ++chore->m_targetTime;
+        }
+
+      chore->m_fracAccum = (uint16_t) accum;
+    }
+#endif
+
+  Insert (chore, after);
+  TraceEvent (SchedulerTraceRecord::RESCHEDULE, chore);
+
   return (0);
 }
 
 
 // ------------------------------------------------------------------
-/** Insert chore into schedule list.
+/** Insert chore into schedule queue.
  *
+ * When a chore that is already queued expires at the same time,
+ * the new chore is placed right after it, which saves searching
+ * the queue when a batch of chores is rescheduled.
  *
+ * @param[in] chore - chore to insert
+ * @param[in] after - chore that may expire at the same time, or 0
  */
 
 void Scheduler::
-Insert (SchedulerChore * chore)
+Insert (SchedulerChore * chore, SchedulerChore * after)
 {
   chore->m_parent = this; // assign ownership
-  SchedulerChore * ptr;
+  chore->m_epoch = m_currentEpoch;
 
-  // Insert new chore into the list
-  for (ptr = m_next; ptr != this; ptr = ptr->m_next)
+  if (after != 0 && after->m_parent == this && after->IsQueued()
+      && after->m_targetTime == chore->m_targetTime)
     {
-      if (*chore < *ptr)
-        {
-          chore->InsertBefore (ptr);
-        }
-    } // end for
-
-  if (ptr == this)
+      m_queue->InsertAfter (after, chore);
+    }
+  else
     {
-      // insert at end
-      chore->InsertBefore (this);
+      m_queue->Insert (chore);
     }
 }
 
 
 // ----------------------------------------------------------------------------
-/** Abort a scheduled chore.
+/** Trigger a chore.
  *
- * This method forcably removes the specified chore from the
- * scheduling list.
+ * This method makes a scheduled chore expire now, so it will be
+ * dispatched by the current or next pass of the scheduler.  This
+ * is how event chores are run. A periodic chore that is
+ * triggered continues its period from the time it was triggered.
+ * With a delay, the chore expires that much later instead, which
+ * replaces any earlier trigger.
  *
- * @param[in] chore - the chore to abort.
+ * @param[in] chore - chore to trigger
+ * @param[in] delay - time until the chore expires, milli-seconds
  *
- * @retval 0 - chore removed
- * @retval -1 - chore not in list
+ * @retval 0 - chore triggered
+ * @retval -1 - chore not attached to this scheduler
  */
 
 int Scheduler::
-AbortChore (SchedulerChore * chore)
+Trigger (SchedulerChore * chore, uint32_t delay)
 {
-  
-  if (m_parent != 0)
+  if (chore->m_parent != this || ! chore->IsScheduled())
     {
-      // remove from list
-      chore->Remove();
+      return (-1);
     }
-  
-  // always unlink from scheduler
-  chore->m_parent = 0;      
-  
+
+  if (chore->IsQueued())
+    {
+      m_queue->Remove (chore);
+    }
+
+  chore->m_targetTime = GetCurrentTime() + delay;
+  Insert (chore);
+  TraceEvent (SchedulerTraceRecord::TRIGGER, chore);
+
   return (0);
 }
 
 
 // ----------------------------------------------------------------------------
-/** Get current time in milli-seconds.
+/** Dispatch chores.
  *
- * This method returns the current time in milli-seconds from the
- * start of the epoch.
+ * This method runs a chore, or a set of chores of one batch,
+ * records the dispatch in the trace if one is attached, and
+ * accounts the run time to the load statistics and timing
+ * histograms.  The run time of a batch is shared equally by its
+ * chores.
  *
+ * @param[in] chores - chores to run
+ * @param[in] count - number of chores
  */
 
-uint32_t Scheduler::
-GetCurrentTime() const
+void Scheduler::
+Dispatch (SchedulerChore * const * chores, uint8_t count)
 {
-  return (millis() - m_baseTime);
-}
-
+#if defined (SCHEDULER_TRACE) || defined (SCHEDULER_HISTOGRAM)
+  uint32_t target = chores[0]->m_targetTime;
+  uint32_t start = GetCurrentTime();
+#endif
+
+#if defined (SCHEDULER_TIME_DISPATCH)
+  uint32_t start_us = ReadMicros();
+#endif
+
+#if defined (SCHEDULER_WATCHDOG)
+  SchedulerWatchdogSlot outer;
+  SchedulerWatchdog::Enter (chores[0]->m_id, chores[0]->m_maxRunTime, outer);
+#endif
+
+#if defined (SCHEDULER_BATCHES)
+  if (chores[0]->m_batch != 0)
+    {
+      chores[0]->m_batch->RunBatch (chores, count);
+    }
+  else
+#else
+  (void) count;
+#endif
+    {
+      chores[0]->Run();
+    }
 
-// ==================================================================
-// TimerWrap methods
-//
+#if defined (SCHEDULER_WATCHDOG)
+  SchedulerWatchdog::Leave (outer);
+#endif
 
-TimerWrap::
-TimerWrap()
-{
-  m_targetTime = 0x40000000;
-}
+#if defined (SCHEDULER_RECORD)
+  for (uint8_t i = 0; i < count; ++i)
+    {
+      SchedulerLog::Dispatched (chores[i]->m_id);
+    }
+#endif
 
-void TimerWrap::
-Run()
-{
-  // adjust the base time
-  m_targetTime += 0x40000000;
+#if defined (SCHEDULER_TIME_DISPATCH)
+  uint32_t run_us = (ReadMicros() - start_us) / count;
 
-  // adjust all chore time values
-  for (SchedulerChore * ptr = m_next; ptr != this; ptr = ptr->m_next)
+  for (uint8_t i = 0; i < count; ++i)
     {
-      // subtract 0x40000000 from target time
-      ptr->m_targetTime &= 0x3fffffff;
-    } // end for
-}
+      SchedulerChore * chore = chores[i];
 
+# if defined (SCHEDULER_TRACE)
+      if (m_trace != 0)
+        {
+          m_trace->Record (SchedulerTraceRecord::DISPATCH, chore->m_id,
+                           target, start, run_us);
+        }
+# endif
+
+# if defined (SCHEDULER_LOAD_STATS)
+      AccountLoad (chore, run_us);
+# endif
+
+# if defined (SCHEDULER_HISTOGRAM)
+      // a chore may be dispatched up to 1 msec early
+      int32_t late (start - target);
+      chore->m_lateness.Add (late > 0 ? late : 0);
+      chore->m_runTime.Add (run_us);
+# endif
+    }
+#endif
+}
 
-// ============================================================================
-// Scheduler Chore methods
-//
 
 // ----------------------------------------------------------------------------
-/** Constructor. 
+/** Record a scheduler event.
  *
- * A new chore object is created and initialized.  Since no
- * scheduling interval is specified, a zero is used and the
- * interval must be set before the chore is scheduled.
+ * This method records an event for a chore in the trace, if one
+ * is attached. It does nothing unless SCHEDULER_TRACE is
+ * defined.
+ *
+ * @param[in] reason - what happened, from SchedulerTraceRecord::Reason
+ * @param[in] chore - chore the event applies to
  */
 
-SchedulerChore::
-SchedulerChore()
-  : m_parent(0),
-    m_targetTime (0),
-    m_interval(0),
-    m_next(0), m_prev(0)
-{ 
-
+void Scheduler::
+TraceEvent (uint8_t reason, SchedulerChore * chore)
+{
+#if defined (SCHEDULER_TRACE)
+  if (m_trace != 0)
+    {
+      m_trace->Record (reason, chore->m_id, chore->m_targetTime,
+                       GetCurrentTime());
+    }
+#else
+  (void) reason;
+  (void) chore;
+#endif
 }
 
 
 // ----------------------------------------------------------------------------
-/** Constructor. 
- *
- * An object with the specified interval is created.  If no
- * scheduling interval is specified, a zero is used and the
- * interval must be set before the chore is scheduled.
+/** Update load window.
  *
- * @param[in] inter - scheduling interval in milli-seconds
+ * This method closes the current load measurement window when it
+ * has run its length, so the busy time of the window can be
+ * reported. It does nothing unless SCHEDULER_LOAD_STATS is
+ * defined.
  */
 
-SchedulerChore::
-SchedulerChore(uint32_t inter)
-  : m_parent(0),
-    m_targetTime (0),
-    m_interval(inter),
-    m_next(0), m_prev(0)
+void Scheduler::
+UpdateLoad ()
 {
-  // limit interval
-  m_interval &= 0x0fffffff;
+#if defined (SCHEDULER_LOAD_STATS)
+  uint32_t now = ReadMicros();
+  uint32_t elapsed = now - m_windowStart;
+
+  if (elapsed >= (uint32_t) m_loadWindow * 1000)
+    {
+      m_lastBusyTime = m_busyTime;
+      m_lastWindowTime = elapsed;
+      m_busyTime = 0;
+      m_windowStart = now;
+      ++m_window;
+    }
+#endif
 }
 
 
 // ----------------------------------------------------------------------------
-/** Destructor.
+/** Account chore run time.
  *
- * This method cleans up a chore before the storage is released.
- * If we are still connected to a parent scheduler, then we
- * abort this chore to make sure we will never be scheduled
- * again. If the chore is running at this time, there is not
- * much we can do about synchronizing the termination because we
- * would have to make some wild assumptions about the run time
- * of this chore. Therefore, synchronizing object destruction
- * with chore termination is the responsibility of the derived
- * class.
+ * This method adds the run time of a chore to the busy time of
+ * the scheduler and the chore.  The chore's window is brought up
+ * to date here rather than when the window closes, so closing a
+ * window does not visit every chore.
+ *
+ * @param[in] chore - chore that has run
+ * @param[in] run_us - run time, micro-seconds
  */
 
-SchedulerChore::
-~SchedulerChore()
+void Scheduler::
+AccountLoad (SchedulerChore * chore, uint32_t run_us)
 {
-  m_parent = 0; // orphan this chore
+#if defined (SCHEDULER_LOAD_STATS)
+  m_busyTime += run_us;
+
+  if (chore->m_window != m_window)
+    {
+      if (chore->m_window == (uint8_t) (m_window - 1))
+        {
+          chore->m_lastBusyTime = chore->m_busyTime;
+        }
+      else
+        {
+          chore->m_lastBusyTime = 0;
+        }
+
+      chore->m_busyTime = 0;
+      chore->m_window = m_window;
+    }
+
+  chore->m_busyTime += run_us;
+#else
+  (void) chore;
+  (void) run_us;
+#endif
 }
 
 
 // ----------------------------------------------------------------------------
-/** Abort this chore. 
+/** Adjust degrade level.
  *
- * This method aborts this chore by removing it from the
- * schedulers list of chores, if it is in there.
+ * The lateness of a dispatch is added to the running average.
+ * The degrade level is raised when the average is above the high
+ * limit, or the load is above SCHEDULER_ADAPT_LOAD, and lowered
+ * when the average is below the low limit and the load is well
+ * under it.  The level changes at most once every
+ * SCHEDULER_ADAPT_HOLD milli-seconds, so the chores that were
+ * stretched have time to make a difference.
+ *
+ * The level is not raised past SCHEDULER_ADAPT_MAX_LEVEL.  It is
+ * raised again if the last raise made the scheduler less late (or
+ * less loaded), or if the scheduler is still falling behind.  If
+ * the lateness stayed the same, stretching chores does not help,
+ * and the level is held so it does not wind up; the lateness is
+ * then measured again from there each hold period.
+ *
+ * @param[in] late - how late the dispatch is, milli-seconds
  */
 
-int SchedulerChore::
-AbortChore() 
+void Scheduler::
+Adapt (int32_t late)
 {
-  if (m_parent != 0)
+#if defined (SCHEDULER_ADAPTIVE)
+  if (late < 0)
     {
-      return m_parent->AbortChore (this);
+      late = 0;
     }
-  else
+  else if (late > 0x0fff)
     {
-      return (-1);
+      late = 0x0fff;
+    }
+
+  // average over about eight dispatches
+  m_lateAvg = m_lateAvg - (m_lateAvg >> 3) + (uint16_t) (late << 1);
+
+  uint32_t now = GetCurrentTime();
+  if (now - m_adaptTime < SCHEDULER_ADAPT_HOLD)
+    {
+      return;
+    }
+
+  bool over = (AverageLateness() > m_adaptHigh);
+  bool under = (AverageLateness() < m_adaptLow);
+
+# if defined (SCHEDULER_LOAD_STATS)
+  uint16_t load = Load();
+  over = over || (load > SCHEDULER_ADAPT_LOAD);
+  under = under && (load < SCHEDULER_ADAPT_LOAD * 3 / 4);
+# endif
+
+  // did the last raise help, or is it getting worse; a change of
+  // less than a milli-second or one percent is no change
+  bool better = (m_lateAvg + 16 <= m_adaptLate);
+  bool worse = (m_lateAvg >= m_adaptLate + 16);
+# if defined (SCHEDULER_LOAD_STATS)
+  better = better || (load + 10 <= m_adaptLoad);
+  worse = worse || (load >= m_adaptLoad + 10);
+# endif
+
+  if (over && (better || worse)
+      && m_adaptLevel < SCHEDULER_ADAPT_MAX_LEVEL)
+    {
+      ++m_adaptLevel;
+      m_adaptTime = now;
+      m_adaptLate = m_lateAvg;
+# if defined (SCHEDULER_LOAD_STATS)
+      m_adaptLoad = load;
+# endif
+    }
+  else if (over)
+    {
+      // hold the level, and compare with now next time
+      m_adaptTime = now;
+      m_adaptLate = m_lateAvg;
+# if defined (SCHEDULER_LOAD_STATS)
+      m_adaptLoad = load;
+# endif
+    }
+  else if (under && m_adaptLevel > 0)
+    {
+      --m_adaptLevel;
+      m_adaptTime = now;
+
+      // raising may help again
+      m_adaptLate = 0xffff;
+# if defined (SCHEDULER_LOAD_STATS)
+      m_adaptLoad = 0xffff;
+# endif
     }
+#else
+  (void) late;
+#endif
 }
 
 
-// ------------------------------------------------------------------
-/** Insert before a chore.
+#if defined (SCHEDULER_ADAPTIVE)
+
+// ----------------------------------------------------------------------------
+/** Set lateness limits for degrading.
  *
- * This method inserts this chore into tthe linked list of
- * chores before the specified chore.
+ * The degrade level is raised while the average lateness is above
+ * the high limit and lowered while it is below the low limit.
+ * The gap between the limits keeps the level from flipping back
+ * and forth.  The defaults are 10 and 2 milli-seconds.
+ *
+ * @param[in] high - lateness that raises the level, milli-seconds
+ * @param[in] low - lateness that lowers the level, milli-seconds
  */
 
-void SchedulerChore::
-InsertBefore (SchedulerChore * c)
+void Scheduler::
+AdaptLimits (uint16_t high, uint16_t low)
 {
-  c->m_next = this;
-  c->m_prev = this->m_prev;
-
-  this->m_prev->m_next = c;
-  this->m_prev = c;  
+  m_adaptHigh = high;
+  m_adaptLow = (low < high) ? low : high;
 }
 
+#endif
 
-// ------------------------------------------------------------------
-/** Remove this chore from list.
+
+#if defined (SCHEDULER_LOAD_STATS)
+
+// ----------------------------------------------------------------------------
+/** Get CPU load.
  *
+ * This method returns the fraction of the last measurement window
+ * that was spent running chores.
  *
+ * @return load in parts per thousand.
  */
 
-void SchedulerChore::
-Remove()
+uint16_t Scheduler::
+Load() const
 {
-      m_prev->m_next = this->m_next;
-      m_next->m_prev = this->m_prev;
+  if (m_lastWindowTime < 1000)
+    {
+      return (0);
+    }
 
-      m_next = 0;
-      m_prev = 0;
+  return (uint16_t) (m_lastBusyTime / (m_lastWindowTime / 1000));
 }
 
+
+// ----------------------------------------------------------------------------
+/** Get CPU load of a chore.
+ *
+ * This method returns the fraction of the last measurement window
+ * that was spent running the specified chore.
+ *
+ * @param[in] chore - chore to report
+ *
+ * @return load in parts per thousand.
+ */
+
+uint16_t Scheduler::
+ChoreLoad (const SchedulerChore * chore) const
+{
+  uint32_t busy = 0;
+
+  if (chore->m_window == m_window)
+    {
+      busy = chore->m_lastBusyTime;
+    }
+  else if (chore->m_window == (uint8_t) (m_window - 1))
+    {
+      busy = chore->m_busyTime;
+    }
+
+  if (m_lastWindowTime < 1000)
+    {
+      return (0);
+    }
+
+  return (uint16_t) (busy / (m_lastWindowTime / 1000));
+}
+
+#endif
+
+
+#if defined (SCHEDULER_DEPENDENCIES)
+// ----------------------------------------------------------------------------
+/** Complete a chore.
+ *
+ * This method is called after a chore has run. The chore is
+ * recorded as an input of each chore that depends on it, and a
+ * dependent chore that has all its inputs is triggered.
+ *
+ * @param[in] chore - chore that has completed
+ */
+
+void Scheduler::
+Complete (SchedulerChore * chore)
+{
+  for (ChoreDependency * dep = chore->m_successors; dep != 0; dep = dep->m_next)
+    {
+      SchedulerChore * succ = dep->m_successor;
+
+      succ->m_inputsDone |= dep->m_bit;
+      if (succ->m_inputsDone == succ->m_inputMask)
+        {
+          succ->m_inputsDone = 0;
+          succ->Trigger();
+        }
+    } // end for
+}
+#endif
+
+
+// ----------------------------------------------------------------------------
+/** Abort a scheduled chore.
+ *
+ * This method forcably removes the specified chore from the
+ * scheduling list.
+ *
+ * @param[in] chore - the chore to abort.
+ *
+ * @retval 0 - chore removed
+ * @retval -1 - chore not in list
+ */
+
+int Scheduler::
+AbortChore (SchedulerChore * chore)
+{
+  if (chore->m_parent != this)
+    {
+      return (-1);
+    }
+
+  // a running or previously aborted chore is not in the list
+  if (chore->IsQueued())
+    {
+      // remove from list
+      m_queue->Remove (chore);
+    }
+  
+  // always unlink from scheduler
+  chore->m_parent = 0;      
+  TraceEvent (SchedulerTraceRecord::ABORT, chore);
+  
+  return (0);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Abort all scheduled chores.
+ *
+ * This method removes all chores from the scheduling list.  The
+ * queue detaches each pending chore, which costs one pass over
+ * the chores but no Remove, Run or Reschedule of each.  The
+ * scheduler epoch is advanced, which orphans the chores that are
+ * running and so not in the queue; they are detached when they
+ * return.  The aborted chores can then be scheduled again.
+ */
+
+void Scheduler::
+AbortAllChores ()
+{
+  m_queue->Clear();
+
+  ++m_currentEpoch;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Select queue policy.
+ *
+ * This method sets the queue that holds the pending chores.  Any
+ * chores already pending are moved to the new queue.  Passing 0
+ * selects the default sorted queue.
+ *
+ * @param[in] queue - queue to use, owned by the caller
+ */
+
+void Scheduler::
+Queue (SchedulerQueue * queue)
+{
+  if (queue == 0)
+    {
+      queue = & m_defaultQueue;
+    }
+
+  SchedulerChore * chore;
+
+  while ((chore = m_queue->Head()) != 0)
+    {
+      m_queue->Remove (chore);
+      queue->Insert (chore);
+    }
+
+  m_queue = queue;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Suspend this scheduler.
+ *
+ * This method stops the scheduler from dispatching chores.  The
+ * scheduler clock is frozen, so the time remaining before each
+ * chore expires is kept while the scheduler is suspended.  If
+ * this scheduler is a chore of another scheduler, it is removed
+ * from that scheduler until resumed.
+ *
+ * @retval 0 - scheduler suspended
+ * @retval -1 - scheduler already suspended
+ */
+
+int Scheduler::
+Suspend ()
+{
+  if (m_suspended)
+    {
+      return (-1);
+    }
+
+  m_suspendTime = GetCurrentTime();
+  m_suspended = true;
+
+  m_owner = m_parent;
+  if (m_owner != 0)
+    {
+      m_owner->AbortChore (this);
+    }
+
+  return (0);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Resume this scheduler.
+ *
+ * This method restarts a suspended scheduler.  The scheduler
+ * clock continues from where it was suspended, so the chores
+ * keep their phase relative to each other and the time spent
+ * suspended is not counted.  If the scheduler was a chore of
+ * another scheduler, it is scheduled there again.
+ *
+ * @retval 0 - scheduler resumed
+ * @retval -1 - scheduler not suspended
+ */
+
+int Scheduler::
+Resume ()
+{
+  if (! m_suspended)
+    {
+      return (-1);
+    }
+
+  m_suspended = false;
+  m_baseTime = Millis() - m_suspendTime;
+
+  if (m_owner != 0)
+    {
+      m_owner->Schedule (this);
+      m_owner = 0;
+    }
+
+  return (0);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Check for an urgent chore.
+ *
+ * Only a chore whose time has come counts, not one that would be
+ * dispatched a milli-second early, so a chore triggered to
+ * continue now is queued after it.
+ *
+ * @param[in] priority - priority of the running chore
+ * @return true if the next chore is due and of higher priority.
+ */
+
+bool Scheduler::
+UrgentDue (uint8_t priority)
+{
+  SchedulerChore * chore = m_queue->Head();
+  if (chore == 0 || m_suspended || chore->Priority() <= priority)
+    {
+      return (false);
+    }
+
+  int32_t delta (chore->m_targetTime - GetCurrentTime());
+  return (delta <= 0);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Get time until the next chore.
+ *
+ * This method returns the time until the next chore in the queue
+ * is due, which is how long the board may sleep.
+ *
+ * @return time in milli-seconds, 0 if a chore is due, or
+ * 0xffffffff if no chore is queued or the scheduler is
+ * suspended.
+ */
+
+uint32_t Scheduler::
+TimeToNext ()
+{
+  SchedulerChore * chore = m_queue->Head();
+  if (chore == 0 || m_suspended)
+    {
+      return (0xffffffff);
+    }
+
+  int32_t delta (chore->m_targetTime - GetCurrentTime());
+  return (delta > 0) ? delta : 0;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Get milli-second clock, counting time asleep.
+ *
+ * This method returns millis() plus the time the clock was
+ * stopped while a PowerPolicy slept.  It is shared by all
+ * schedulers, and other schedulers and chores that keep time
+ * should read it instead of millis().
+ *
+ * @return clock, milli-seconds
+ */
+
+uint32_t Scheduler::
+Millis()
+{
+  return (millis() + s_slept);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Get current time in milli-seconds.
+ *
+ * This method returns the current time in milli-seconds from the
+ * start of the epoch.
+ *
+ */
+
+uint32_t Scheduler::
+GetCurrentTime() const
+{
+  if (m_suspended)
+    {
+      return (m_suspendTime);
+    }
+
+#if defined (SCHEDULER_RECORD)
+  return SchedulerLog::Time (Millis() - m_baseTime);
+#else
+  return (Millis() - m_baseTime);
+#endif
+}
+
+
+// ----------------------------------------------------------------------------
+/** Save chore schedule.
+ *
+ * The id, remaining time and interval of each of the specified
+ * chores that is scheduled in this scheduler are written to the
+ * buffer, so the schedule can be kept over a reset or deep sleep
+ * and resumed with RestoreState().  Chores are matched by id, so
+ * the chores saved must have distinct ids.  A chore that is past
+ * due is saved as due now.  Each chore takes 3 to 11 bytes, and
+ * the block 5 more.
+ *
+ * Example:
+\code
+uint8_t state[64];
+uint16_t len = the_scheduler.SaveState (chores, CHORE_COUNT,
+                                        state, sizeof (state));
+for (uint16_t i = 0; i < len; ++i)
+  {
+    EEPROM.write (i, state[i]);
+  }
+\endcode
+ *
+ * @param[in] chores - chores to save
+ * @param[in] count - number of chores
+ * @param[out] buf - buffer to write to
+ * @param[in] size - size of buffer, bytes
+ * @return number of bytes written, or 0 if the buffer is too small.
+ */
+
+uint16_t Scheduler::
+SaveState (SchedulerChore * const * chores, uint8_t count,
+           uint8_t * buf, uint16_t size) const
+{
+  if (size < STATE_HEADER_SIZE + 1)
+    {
+      return (0);
+    }
+
+  uint32_t now = GetCurrentTime();
+  uint16_t pos = STATE_HEADER_SIZE;
+  uint8_t saved = 0;
+
+  for (uint8_t i = 0; i < count; ++i)
+    {
+      SchedulerChore * chore = chores[i];
+      if (chore->m_parent != this || ! chore->IsScheduled())
+        {
+          continue;
+        }
+
+      int32_t remain = (chore->m_interval == 0)
+        ? 0
+        : (int32_t) (chore->m_targetTime - now);
+
+      if (pos >= size)
+        {
+          return (0);
+        }
+
+      buf[pos++] = chore->m_id;
+      pos = PutNumber (buf, pos, size, (remain < 0) ? 0 : remain);
+      if (pos != 0)
+        {
+          pos = PutNumber (buf, pos, size, chore->m_interval);
+        }
+
+      if (pos == 0)
+        {
+          return (0);
+        }
+
+      ++saved;
+    } // end for
+
+  if (pos >= size)
+    {
+      return (0);
+    }
+
+  buf[0] = 'S';
+  buf[1] = 'S';
+  buf[2] = STATE_VERSION;
+  buf[3] = saved;
+  buf[pos] = StateCheck (buf, pos);
+
+  return (pos + 1);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Restore chore schedule.
+ *
+ * The chores in a block written by SaveState() are scheduled in
+ * this scheduler with the remaining time they had when saved,
+ * less the time slept since, so they resume their phase instead
+ * of starting a full interval from now.  A chore whose time ran
+ * out while asleep is due now.  Each saved chore is matched by id
+ * to one of the specified chores.  A matching chore that is
+ * already scheduled is moved, so the usual setup can schedule
+ * all chores and then restore; chores not in the block keep
+ * their new schedule.
+ *
+ * @param[in] chores - chores that may be restored
+ * @param[in] count - number of chores
+ * @param[in] buf - block written by SaveState()
+ * @param[in] size - size of block, bytes
+ * @param[in] slept - time passed since the block was saved,
+ * milli-seconds
+ *
+ * @return number of chores restored, or -1 if the block is not
+ * valid.
+ */
+
+int Scheduler::
+RestoreState (SchedulerChore * const * chores, uint8_t count,
+              const uint8_t * buf, uint16_t size, uint32_t slept)
+{
+  if (size < STATE_HEADER_SIZE + 1
+      || buf[0] != 'S' || buf[1] != 'S' || buf[2] != STATE_VERSION
+      || buf[size - 1] != StateCheck (buf, size - 1))
+    {
+      return (-1);
+    }
+
+  uint32_t now = GetCurrentTime();
+  uint16_t pos = STATE_HEADER_SIZE;
+  int restored = 0;
+
+  for (uint8_t n = buf[3]; n > 0; --n)
+    {
+      uint32_t remain;
+      uint32_t inter;
+
+      if (pos >= size - 1)
+        {
+          return (-1);
+        }
+
+      uint8_t id = buf[pos++];
+      pos = GetNumber (buf, pos, size - 1, remain);
+      if (pos != 0)
+        {
+          pos = GetNumber (buf, pos, size - 1, inter);
+        }
+
+      if (pos == 0)
+        {
+          return (-1);
+        }
+
+      for (uint8_t i = 0; i < count; ++i)
+        {
+          SchedulerChore * chore = chores[i];
+          if (chore->m_id != id)
+            {
+              continue;
+            }
+
+          if (chore->IsScheduled())
+            {
+              chore->AbortChore();
+            }
+
+          // keep the fraction of a chore set with Period()
+          if (chore->m_interval != inter)
+            {
+              chore->Interval (inter);
+            }
+
+          if (inter == 0)
+            {
+              Schedule (chore);
+            }
+          else
+            {
+              chore->m_targetTime = now + ((slept < remain) ? remain - slept : 0);
+#if defined (SCHEDULER_FRACTIONAL_PERIODS)
+              chore->m_fracAccum = 0;
+#endif
+              Insert (chore);
+              TraceEvent (SchedulerTraceRecord::SCHEDULE, chore);
+            }
+
+          ++restored;
+          break;
+        } // end for
+    } // end for
+
+  return (restored);
+}
+
+
+// ============================================================================
+// Sorted Chore Queue methods
+//
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * An empty queue is created.
+ */
+
+SortedChoreQueue::
+SortedChoreQueue()
+{
+  Next (& m_head) = & m_head;
+  Prev (& m_head) = & m_head;
+}
+
+
+// ------------------------------------------------------------------
+/** Insert chore into list.
+ *
+ * The chore is inserted after all chores that expire at the same
+ * time or earlier.
+ */
+
+void SortedChoreQueue::
+Insert (SchedulerChore * chore)
+{
+  SchedulerChore * ptr;
+
+  // Find the first chore that expires after the new one
+  for (ptr = Next (& m_head); ptr != & m_head; ptr = Next (ptr))
+    {
+      if (*chore < *ptr)
+        {
+          break;
+        }
+    } // end for
+
+  // insert in front of that chore, or at the end of the list
+  LinkBefore (chore, ptr);
+}
+
+
+// ------------------------------------------------------------------
+/** Remove chore from list.
+ *
+ */
+
+void SortedChoreQueue::
+Remove (SchedulerChore * chore)
+{
+  Unlink (chore);
+}
+
+
+// ------------------------------------------------------------------
+/** Get first chore in list.
+ *
+ */
+
+SchedulerChore * SortedChoreQueue::
+Head ()
+{
+  SchedulerChore * first = Next (& m_head);
+
+  return (first == & m_head) ? 0 : first;
+}
+
+
+// ------------------------------------------------------------------
+/** Insert chore after another.
+ *
+ * The chore is linked right after a queued chore with the same
+ * expiration time, without searching the list.
+ */
+
+void SortedChoreQueue::
+InsertAfter (SchedulerChore * pos, SchedulerChore * chore)
+{
+  LinkBefore (chore, Next (pos));
+}
+
+
+// ------------------------------------------------------------------
+/** Empty the list.
+ *
+ * Each chore is detached, without unlinking it from its
+ * neighbours one by one.
+ */
+
+void SortedChoreQueue::
+Clear ()
+{
+  SchedulerChore * ptr = Next (& m_head);
+  while (ptr != & m_head)
+    {
+      SchedulerChore * next = Next (ptr);
+      Detach (ptr);
+      ptr = next;
+    }
+
+  Next (& m_head) = & m_head;
+  Prev (& m_head) = & m_head;
+}
+
+
+// ============================================================================
+// Scheduler Chore methods
+//
+
+// ----------------------------------------------------------------------------
+/** Constructor. 
+ *
+ * A new chore object is created and initialized.  Since no
+ * scheduling interval is specified, a zero is used and the
+ * interval must be set before the chore is scheduled.
+ */
+
+SchedulerChore::
+SchedulerChore()
+  : m_parent(0),
+    m_epoch(0),
+    m_id(0),
+#if defined (SCHEDULER_PRIORITY)
+    m_priority(0),
+#endif
+#if defined (SCHEDULER_LOAD_STATS)
+    m_busyTime(0),
+    m_lastBusyTime(0),
+    m_window(0),
+#endif
+    m_targetTime (0),
+    m_interval(0),
+#if defined (SCHEDULER_FRACTIONAL_PERIODS)
+    m_fracNum(0),
+    m_fracDen(1),
+    m_fracAccum(0),
+#endif
+#if defined (SCHEDULER_DEPENDENCIES)
+    m_successors(0),
+    m_inputMask(0),
+    m_inputsDone(0),
+#endif
+#if defined (SCHEDULER_BATCHES)
+    m_batch(0),
+#endif
+#if defined (SCHEDULER_WATCHDOG)
+    m_maxRunTime(SCHEDULER_WATCHDOG_TIMEOUT),
+#endif
+#if defined (SCHEDULER_INTERVAL_QUEUE)
+    m_order(0),
+#endif
+    m_next(0), m_prev(0)
+{ 
+
+}
+
+
+// ----------------------------------------------------------------------------
+/** Constructor. 
+ *
+ * An object with the specified interval is created.  If no
+ * scheduling interval is specified, a zero is used and the
+ * interval must be set before the chore is scheduled.
+ *
+ * @param[in] inter - scheduling interval in milli-seconds
+ */
+
+SchedulerChore::
+SchedulerChore(uint32_t inter)
+  : m_parent(0),
+    m_epoch(0),
+    m_id(0),
+#if defined (SCHEDULER_PRIORITY)
+    m_priority(0),
+#endif
+#if defined (SCHEDULER_LOAD_STATS)
+    m_busyTime(0),
+    m_lastBusyTime(0),
+    m_window(0),
+#endif
+    m_targetTime (0),
+    m_interval(inter),
+#if defined (SCHEDULER_FRACTIONAL_PERIODS)
+    m_fracNum(0),
+    m_fracDen(1),
+    m_fracAccum(0),
+#endif
+#if defined (SCHEDULER_DEPENDENCIES)
+    m_successors(0),
+    m_inputMask(0),
+    m_inputsDone(0),
+#endif
+#if defined (SCHEDULER_BATCHES)
+    m_batch(0),
+#endif
+#if defined (SCHEDULER_WATCHDOG)
+    m_maxRunTime(SCHEDULER_WATCHDOG_TIMEOUT),
+#endif
+#if defined (SCHEDULER_INTERVAL_QUEUE)
+    m_order(0),
+#endif
+    m_next(0), m_prev(0)
+{
+  // limit interval
+  m_interval &= 0x0fffffff;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Destructor.
+ *
+ * This method cleans up a chore before the storage is released.
+ * If we are still connected to a parent scheduler, then we
+ * abort this chore to make sure we will never be scheduled
+ * again. If the chore is running at this time, there is not
+ * much we can do about synchronizing the termination because we
+ * would have to make some wild assumptions about the run time
+ * of this chore. Therefore, synchronizing object destruction
+ * with chore termination is the responsibility of the derived
+ * class.
+ */
+
+SchedulerChore::
+~SchedulerChore()
+{
+  AbortChore(); // orphan this chore
+}
+
+
+#if defined (SCHEDULER_FRACTIONAL_PERIODS)
+// ----------------------------------------------------------------------------
+/** Set a fractional period.
+ *
+ * This method sets the reschedule interval to num / den
+ * milli-seconds.  The whole part is used as the interval and the
+ * remainder is accumulated each time the chore is rescheduled, so
+ * the chore stays locked to the exact frequency with no drift.
+ * For example, Period (1000, 30) runs a chore at 30 Hz.  The
+ * period must be at least one milli-second.  This method is only
+ * built when SCHEDULER_FRACTIONAL_PERIODS is defined in
+ * SchedulerConfig.h.
+ *
+ * @param[in] num - period numerator, milli-seconds
+ * @param[in] den - period denominator
+ */
+
+void SchedulerChore::
+Period (uint32_t num, uint16_t den)
+{
+  if (den == 0)
+    {
+      den = 1;
+    }
+
+  Interval (num / den);
+
+  m_fracNum = (uint16_t) (num % den);
+  m_fracDen = den;
+  m_fracAccum = 0;
+}
+#endif
+
+
+// ----------------------------------------------------------------------------
+/** Abort this chore. 
+ *
+ * This method aborts this chore by removing it from the
+ * schedulers list of chores, if it is in there.
+ */
+
+int SchedulerChore::
+AbortChore() 
+{
+  if (m_parent != 0)
+    {
+      return m_parent->AbortChore (this);
+    }
+  else
+    {
+      return (-1);
+    }
+}
+
+
+#if defined (SCHEDULER_HISTOGRAM)
+
+// ----------------------------------------------------------------------------
+/** Clear timing histograms.
+ *
+ * This method discards the lateness and run time values counted
+ * for this chore, for example before measuring the effect of a
+ * change.
+ */
+
+void SchedulerChore::
+ClearHistograms()
+{
+  m_lateness.Clear();
+  m_runTime.Clear();
+}
+
+#endif
+
+
+// ----------------------------------------------------------------------------
+/** Trigger this chore.
+ *
+ * This method asks the scheduler that owns this chore to
+ * dispatch it now.
+ */
+
+int SchedulerChore::
+Trigger()
+{
+  if (m_parent != 0)
+    {
+      return m_parent->Trigger (this);
+    }
+  else
+    {
+      return (-1);
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Check for a more urgent chore.
+ *
+ * This method may be called from Run() by a chore that takes a
+ * long time, to learn whether it should return early so a chore
+ * of higher priority can run.  It looks at the next chore of its
+ * scheduler, and of each scheduler that scheduler is nested in.
+ * A chore that returns early can be resumed by the scheduler, see
+ * ResumableChore.
+ *
+ * Priorities are only kept when SCHEDULER_PRIORITY is defined in
+ * SchedulerConfig.h.  Without it all chores are equal and this
+ * method always returns false.
+ *
+ * @retval true - a chore of higher priority is due
+ * @retval false - carry on
+ */
+
+bool SchedulerChore::
+ShouldYield ()
+{
+  for (Scheduler * sched = m_parent; sched != 0; sched = sched->m_parent)
+    {
+      if (sched->UrgentDue (Priority()))
+        {
+          return (true);
+        }
+    }
+
+  return (false);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Is this chore scheduled.
+ *
+ * This method determines if this chore is currently owned by a
+ * scheduler. A chore that was aborted, individually or with all
+ * other chores of its scheduler, is not scheduled.
+ */
+
+bool SchedulerChore::
+IsScheduled() const
+{
+  return (m_parent != 0) && (m_epoch == m_parent->m_currentEpoch);
+}
+
+
+// ------------------------------------------------------------------
+/** Is this chore in its scheduler's queue.
+ *
+ * The links of a chore are only valid in the epoch it was queued
+ * in.  After AbortAllChores() they point into a queue that was
+ * cleared.
+ */
+
+bool SchedulerChore::
+IsQueued() const
+{
+  return (m_next != 0) && IsScheduled();
+}
+
+
+// ------------------------------------------------------------------
+/** Insert before a chore.
+ *
+ * This method inserts this chore into tthe linked list of
+ * chores before the specified chore.
+ */
+
+void SchedulerChore::
+InsertBefore (SchedulerChore * c)
+{
+  this->m_next = c;
+  this->m_prev = c->m_prev;
+
+  c->m_prev->m_next = this;
+  c->m_prev = this;
+}
+
+
+// ------------------------------------------------------------------
+/** Remove this chore from list.
+ *
+ *
+ */
+
+void SchedulerChore::
+Remove()
+{
+      m_prev->m_next = this->m_next;
+      m_next->m_prev = this->m_prev;
+
+      m_next = 0;
+      m_prev = 0;
+}
+
+#if defined (SCHEDULER_DEPENDENCIES)
+// ============================================================================
+// Chore Dependency methods
+//
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * The successor chore is made to depend on the predecessor
+ * chore. Each dependency takes the next free input bit of the
+ * successor. Dependencies beyond the eighth are ignored, and so
+ * is a dependency that would close a cycle, since the chores in
+ * it would trigger each other forever.
+ *
+ * @param[in] pred - chore that must complete first
+ * @param[in] succ - chore that runs when its inputs complete
+ */
+
+ChoreDependency::
+ChoreDependency (SchedulerChore & pred, SchedulerChore & succ)
+  : m_successor (0),
+    m_next (0),
+    m_bit (~succ.m_inputMask & (succ.m_inputMask + 1))
+{
+  if (m_bit == 0 || Reaches (& succ, & pred))
+    {
+      m_bit = 0;
+      return;
+    }
+
+  m_successor = & succ;
+  m_next = pred.m_successors;
+  succ.m_inputMask |= m_bit;
+  pred.m_successors = this;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Is a chore reachable through dependencies.
+ *
+ * @param[in] from - chore to start from
+ * @param[in] to - chore to look for
+ * @return true if to is from, or depends on it directly or
+ * through other chores.
+ */
+
+bool ChoreDependency::
+Reaches (const SchedulerChore * from, const SchedulerChore * to)
+{
+  if (from == to)
+    {
+      return (true);
+    }
+
+  for (ChoreDependency * dep = from->m_successors; dep != 0; dep = dep->m_next)
+    {
+      if (Reaches (dep->m_successor, to))
+        {
+          return (true);
+        }
+    }
+
+  return (false);
+}
+
+#endif
+
 // Local Variables:
 // mode: c++
 // fill-column: 64
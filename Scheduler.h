@@ -22,11 +22,17 @@
 #define Scheduler_H_
 
 #include <inttypes.h>
+#include <SchedulerConfig.h>
+#include <SchedulerHistogram.h>
 
 //
 // forward declarations
 //
 class Scheduler;
+class ChoreDependency;
+class SchedulerTrace;
+class ChoreBatch;
+class PowerPolicy;
 
 // ----------------------------------------------------------------------------
 /** Scheduled chore.
@@ -36,8 +42,10 @@ class Scheduler;
 * are automatically rescheduled by default so they are
 * recurrring activities.
 *
-* This could be enhanced to allow for one time chores and to
-* allow the chore to cancel itself.
+* A chore with an interval of zero is an event chore. It is
+* attached to the scheduler when scheduled, but only runs when
+* triggered, either directly or by the completion of the chores
+* it depends on (see ChoreDependency).
 */
 
 class SchedulerChore
@@ -51,27 +59,102 @@ public:
   bool operator== (const SchedulerChore & rhs) const
   { return (m_targetTime == rhs.m_targetTime); }
 
-  // compares execution times
+  // compares execution times, allowing for clock wrap
   bool operator< (const SchedulerChore & rhs) const
-  { return (m_targetTime < rhs.m_targetTime); }
+  { return (int32_t (m_targetTime - rhs.m_targetTime) < 0); }
 
   /// Return scheduling interval for this chore.
   uint32_t Interval() const { return m_interval; }
 
   /// Set reschedule interval for this chore.
-  void Interval (uint32_t inter) { m_interval = inter & 0x0fffffff; }
+  void Interval (uint32_t inter)
+  {
+    m_interval = inter & 0x0fffffff;
+#if defined (SCHEDULER_FRACTIONAL_PERIODS)
+    m_fracNum = 0;
+#endif
+  }
+
+#if defined (SCHEDULER_FRACTIONAL_PERIODS)
+  void Period (uint32_t num, uint16_t den);
+#endif
+
+  /// Return identifier for this chore.
+  uint8_t Id() const { return m_id; }
+
+  /// Set identifier used to name this chore in traces.
+  void Id (uint8_t id) { m_id = id; }
+
+#if defined (SCHEDULER_PRIORITY)
+  /// Return priority, higher is more important.
+  uint8_t Priority() const { return m_priority; }
+
+  /// Set priority, higher is more important.
+  void Priority (uint8_t pri) { m_priority = pri; }
+#else
+  /// Return priority, all chores are equal.
+  uint8_t Priority() const { return 0; }
+
+  /// Priorities are not kept.
+  void Priority (uint8_t) { }
+#endif
+
+#if defined (SCHEDULER_BATCHES)
+  /// Return batch this chore is dispatched with.
+  ChoreBatch * Batch() const { return m_batch; }
+
+  /// Set batch to dispatch this chore with, or 0 for none.
+  void Batch (ChoreBatch * batch) { m_batch = batch; }
+#endif
+
+#if defined (SCHEDULER_HISTOGRAM)
+  /// Return histogram of dispatch lateness, milli-seconds.
+  const LogHistogram & Lateness() const { return m_lateness; }
+
+  /// Return histogram of Run() duration, micro-seconds.
+  const LogHistogram & RunTime() const { return m_runTime; }
+
+  void ClearHistograms();
+#endif
+
+#if defined (SCHEDULER_WATCHDOG)
+  /// Return longest run time allowed, milli-seconds.
+  uint16_t MaxRunTime() const { return m_maxRunTime; }
+
+  /// Set longest run time allowed, milli-seconds.
+  void MaxRunTime (uint16_t msec) { m_maxRunTime = msec; }
+#endif
 
   int AbortChore();
+  int Trigger();
+
+  bool IsScheduled() const;
 
 
 protected:
+  bool IsQueued() const;
   void InsertBefore (SchedulerChore * c);
   void Remove();
 
+  /// Run a chore directly, for chores that dispatch other chores.
+  static void RunChore (SchedulerChore * c) { c->Run(); }
+
+  /// Return scheduler that owns this chore, or 0.
+  Scheduler * Parent() const { return m_parent; }
+
+  bool ShouldYield ();
+
+  /// Return time this chore expires, milli-seconds.
+  uint32_t TargetTime() const { return m_targetTime; }
+
+  /// Set time this chore expires, only while it runs.
+  void TargetTime (uint32_t time) { m_targetTime = time; }
+
 
 private:
   friend class Scheduler;
-  friend class TimerWrap;
+  friend class ChoreDependency;
+  friend class SchedulerQueue;
 
   /** Procedure to run periodically.  This method is the do-it
    * function for this chore.  All derived classes must supply
@@ -81,12 +164,71 @@ private:
 
   Scheduler * m_parent;
 
+  /// Epoch of the parent when this chore was scheduled.
+  uint8_t m_epoch;
+
+  /// Application assigned identifier.
+  uint8_t m_id;
+
+#if defined (SCHEDULER_PRIORITY)
+  /// Application assigned priority, higher is more important.
+  uint8_t m_priority;
+#endif
+
+#if defined (SCHEDULER_LOAD_STATS)
+  /// Run time in the load window m_window, micro-seconds.
+  uint32_t m_busyTime;
+
+  /// Run time in the window before m_window, micro-seconds.
+  uint32_t m_lastBusyTime;
+  uint8_t m_window;
+#endif
+
+#if defined (SCHEDULER_HISTOGRAM)
+  LogHistogram m_lateness;
+  LogHistogram m_runTime;
+#endif
+
   /// Next scheduled run time, seconds.
   uint32_t m_targetTime;
 
   /// Repeat time in milli-seconds
   uint32_t  m_interval;
 
+#if defined (SCHEDULER_FRACTIONAL_PERIODS)
+  // Fraction of a milli-second added to the repeat time, and
+  // the fraction accumulated so far.
+  uint16_t m_fracNum;
+  uint16_t m_fracDen;
+  uint16_t m_fracAccum;
+#endif
+
+#if defined (SCHEDULER_DEPENDENCIES)
+  /// Chores that depend on this chore.
+  ChoreDependency * m_successors;
+
+  /// One bit for each chore this chore depends on.
+  uint8_t m_inputMask;
+
+  /// Inputs completed in the current period.
+  uint8_t m_inputsDone;
+#endif
+
+#if defined (SCHEDULER_BATCHES)
+  /// Batch that runs this chore, or 0.
+  ChoreBatch * m_batch;
+#endif
+
+#if defined (SCHEDULER_WATCHDOG)
+  /// Longest run time before the watchdog resets, milli-seconds.
+  uint16_t m_maxRunTime;
+#endif
+
+#if defined (SCHEDULER_INTERVAL_QUEUE)
+  /// Insertion order, see IntervalBucketQueue.
+  uint16_t m_order;
+#endif
+
   // List linking fields
   SchedulerChore * m_next;
   SchedulerChore * m_prev;
@@ -98,14 +240,235 @@ private:
 
 
 
-class TimerWrap : public SchedulerChore
+#if defined (SCHEDULER_DEPENDENCIES)
+// ----------------------------------------------------------------------------
+/** Chore dependency.
+ *
+ * This class declares that one chore (the successor) depends on
+ * the output of another chore (the predecessor). When all of its
+ * predecessors have completed, the successor is triggered and is
+ * dispatched in the same pass of the scheduler, so a chain of
+ * chores runs back to back without staggered intervals.
+ *
+ * The successor is usually an event chore (interval zero) that is
+ * scheduled before its inputs complete. A chore may depend on up
+ * to eight predecessors. The dependencies must form no cycle; a
+ * dependency that would close one is ignored, see IsValid().
+ * Dependencies must live as long as the chores they connect.
+ * Dependencies are only built when SCHEDULER_DEPENDENCIES is
+ * defined in SchedulerConfig.h.
+ *
+ * Example:
+\code
+sample_chore   sample (10);   // runs every 10 msec
+filter_chore   filter;        // event chore
+publish_chore  publish;       // event chore
+
+ChoreDependency filter_input (sample, filter);
+ChoreDependency publish_input (filter, publish);
+
+the_scheduler.Schedule (& sample);
+the_scheduler.Schedule (& filter);
+the_scheduler.Schedule (& publish);
+\endcode
+ */
+
+class ChoreDependency
+{
+public:
+  ChoreDependency (SchedulerChore & pred, SchedulerChore & succ);
+
+  /// Return true if the dependency was made, false if ignored.
+  bool IsValid() const { return m_successor != 0; }
+
+private:
+  friend class Scheduler;
+
+  static bool Reaches (const SchedulerChore * from, const SchedulerChore * to);
+
+  SchedulerChore * m_successor;
+
+  /// Next dependency of the same predecessor
+  ChoreDependency * m_next;
+
+  /// Input bit for this dependency in the successor
+  uint8_t m_bit;
+
+  // NON_COPYABLE
+  ChoreDependency (const ChoreDependency &);
+  const ChoreDependency & operator= (const ChoreDependency &);
+};
+#endif
+
+
+#if defined (SCHEDULER_BATCHES)
+// ----------------------------------------------------------------------------
+/** Chore batch.
+ *
+ * This class is the abstract base class for running a set of
+ * chores with one call.  When the scheduler finds that the next
+ * chores to expire all belong to the same batch and expire at the
+ * same time, it removes them together and passes the whole set to
+ * RunBatch() instead of running each chore.  Afterwards the set
+ * is rescheduled together, so chores with the same interval stay
+ * next to each other in the queue.
+ *
+ * This allows a class with many instances, such as LED flashers,
+ * to do one port wide operation for all instances that expire
+ * together.  At most SCHEDULER_BATCH_SIZE chores are passed in
+ * one call.
+ */
+
+class ChoreBatch
+{
+public:
+  virtual ~ChoreBatch() { }
+
+  /** Run a set of chores.  All chores in the set belong to this
+   * batch and expired at the same time.
+   *
+   * @param[in] chores - chores to run
+   * @param[in] count - number of chores
+   */
+  virtual void RunBatch (SchedulerChore * const * chores, uint8_t count) = 0;
+};
+#endif
+
+
+// ----------------------------------------------------------------------------
+/** Scheduler queue policy.
+ *
+ * This class is the abstract base class for the queues that hold
+ * a scheduler's pending chores in order of expiration time.  The
+ * scheduler uses a SortedChoreQueue unless another queue is
+ * selected with Scheduler::Queue(), so the queue can be matched
+ * to the number and mix of chores.
+ *
+ * A queue links chores with their list linking fields.  A chore
+ * is in a queue exactly when its next link is not zero, so Remove
+ * must clear the links, and Clear must Detach() every chore, so
+ * no chore keeps links into the emptied queue.  Chores with the same expiration time
+ * must be returned in the order they were inserted.
+ */
+
+class SchedulerQueue
+{
+public:
+  virtual ~SchedulerQueue() { }
+
+  /// Add chore to the queue.
+  virtual void Insert (SchedulerChore * chore) = 0;
+
+  /// Remove chore from the queue.
+  virtual void Remove (SchedulerChore * chore) = 0;
+
+  /// Return chore that expires first, or 0 if queue is empty.
+  virtual SchedulerChore * Head () = 0;
+
+  /// Add chore that expires at the same time as a queued chore.
+  virtual void InsertAfter (SchedulerChore * pos, SchedulerChore * chore)
+  { (void) pos; Insert (chore); }
+
+  /// Drop all chores, detaching each from its scheduler.
+  virtual void Clear () = 0;
+
+
+protected:
+  // Access to chore fields for derived queues
+  static SchedulerChore *& Next (SchedulerChore * c) { return c->m_next; }
+  static SchedulerChore *& Prev (SchedulerChore * c) { return c->m_prev; }
+  static uint32_t TargetTime (const SchedulerChore * c) { return c->m_targetTime; }
+  static uint32_t Interval (const SchedulerChore * c) { return c->m_interval; }
+
+#if defined (SCHEDULER_INTERVAL_QUEUE)
+  static uint16_t & Order (SchedulerChore * c) { return c->m_order; }
+#endif
+
+  static void LinkBefore (SchedulerChore * c, SchedulerChore * pos) { c->InsertBefore (pos); }
+  static void Unlink (SchedulerChore * c) { c->Remove(); }
+
+  /// Clear the links and the scheduler of a dropped chore.
+  static void Detach (SchedulerChore * c)
+  { c->m_next = 0; c->m_prev = 0; c->m_parent = 0; }
+};
+
+
+// ----------------------------------------------------------------------------
+/** Power policy.
+ *
+ * This class is the abstract base class for putting the board to
+ * sleep while the scheduler has nothing to run.  When a policy is
+ * set with Scheduler::Power(), RunScheduler() passes it the time
+ * until the next chore is due each time it finds nothing to run.
+ * The policy picks the deepest sleep state that can wake up in
+ * that time, sets a timer to wake it, and sleeps.
+ *
+ * Some sleep states stop the clock behind millis().  The policy
+ * returns the time the clock was stopped, and all schedulers,
+ * nested ones included, move their clocks forward by that much,
+ * so chores stay on time.  Scheduler::Millis() includes the
+ * time; millis() does not.
+ */
+
+class PowerPolicy
+{
+public:
+  virtual ~PowerPolicy() { }
+
+  /** Sleep until the next chore is due, or until woken.
+   *
+   * @param[in] idle - time until the next chore, milli-seconds
+   * @return time the millis() clock was stopped, milli-seconds.
+   */
+  virtual uint32_t Sleep (uint32_t idle) = 0;
+};
+
+
+// ----------------------------------------------------------------------------
+/** Chore list head.
+ *
+ * This class is the sentinel node of a list of chores. It is
+ * kept separate from the scheduler so that the scheduler's own
+ * list linking fields are free to link it into the list of a
+ * parent scheduler.
+ */
+
+class SchedulerListHead : public SchedulerChore
+{
+public:
+  SchedulerListHead() { }
+  virtual ~SchedulerListHead() { }
+
+private:
+  virtual void Run() { }
+};
+
+
+// ----------------------------------------------------------------------------
+/** Sorted chore queue.
+ *
+ * This is the default scheduler queue.  Chores are kept in a
+ * doubly linked list sorted by expiration time, so the next chore
+ * is found in constant time and inserting a chore takes time
+ * proportional to the number of chores that expire before it.
+ * This is the best choice for the few chores a small board runs.
+ */
+
+class SortedChoreQueue : public SchedulerQueue
 {
 public:
-  TimerWrap(); 
-  virtual ~TimerWrap() { }
-  
+  SortedChoreQueue ();
+  virtual ~SortedChoreQueue() { }
+
+  virtual void Insert (SchedulerChore * chore);
+  virtual void Remove (SchedulerChore * chore);
+  virtual SchedulerChore * Head ();
+  virtual void Clear ();
+  virtual void InsertAfter (SchedulerChore * pos, SchedulerChore * chore);
+
+
 private:
-  virtual void Run();
+  SchedulerListHead m_head;
 };
 
 
@@ -126,8 +489,41 @@ private:
 * to dispatch chores.
 *
 * The clock is a 32 bit counter which gives about 49.71 days before
-* it will wrap. Currently there is no handling for this timer
-* wrapping, so beware.
+* it will wrap. Expiration times are compared using the signed
+* difference from the current time, so the wrap is harmless as
+* long as chore intervals are less than half the clock range.
+*
+* A scheduler is itself a chore, so a scheduler can be scheduled
+* in another scheduler.  When the parent runs the nested
+* scheduler, the nested scheduler dispatches its own expired
+* chores.  The interval of the nested scheduler sets the rate at
+* which its chores are looked at, and aborting or scheduling the
+* nested scheduler in its parent stops or starts the whole group
+* of chores with a single operation.
+*
+* Pending chores are kept in a SortedChoreQueue by default.  A
+* different queue policy can be selected with Queue() when there
+* are many chores.
+*
+* The remaining time and interval of a set of chores can be saved
+* to a small block with SaveState(), kept in EEPROM or RTC memory
+* over a reset or deep sleep, and restored with RestoreState(),
+* so long period chores keep their phase.
+*
+* When SCHEDULER_ADAPTIVE is defined, the scheduler keeps an
+* average of how late chores are dispatched.  When it falls
+* behind, it raises a degrade level that makes AdaptiveChores of
+* low priority run less often, and lowers it again once it keeps
+* up.  See AdaptLimits().
+*
+* A PowerPolicy set with Power() puts the board to sleep when no
+* chore is due, until the next one is.  Only the top scheduler
+* should be given a policy.
+*
+* A group of chores can also be suspended and resumed, which
+* keeps the remaining time before each chore expires, or
+* aborted all at once.  These operations take the same time no
+* matter how many chores are in the group.
 *
 * Example:
 \code
@@ -183,26 +579,143 @@ class Scheduler
 {
 public:
   Scheduler ();
+  Scheduler (uint32_t inter);
   virtual ~Scheduler();
     
   void RunScheduler ();
 
   int Schedule (SchedulerChore * chore);
   int AbortChore (SchedulerChore * chore);
+  void AbortAllChores ();
+  int Trigger (SchedulerChore * chore, uint32_t delay = 0);
+
+  /// Return scheduler time, milli-seconds.
+  uint32_t Now() const { return GetCurrentTime(); }
+
+  static uint32_t Millis();
+
+  int Suspend ();
+  int Resume ();
+  bool IsSuspended() const { return m_suspended; }
+
+  /// Return true if this scheduler is run by another scheduler.
+  bool IsNested() const { return m_parent != 0; }
+
+  void Queue (SchedulerQueue * queue);
+
+  /// Set policy to sleep with when idle, or 0 to not sleep.
+  void Power (PowerPolicy * policy) { m_power = policy; }
+
+  uint32_t TimeToNext ();
+
+  uint16_t SaveState (SchedulerChore * const * chores, uint8_t count,
+                      uint8_t * buf, uint16_t size) const;
+  int RestoreState (SchedulerChore * const * chores, uint8_t count,
+                    const uint8_t * buf, uint16_t size, uint32_t slept = 0);
+
+#if defined (SCHEDULER_TRACE)
+  /// Set trace to record events in, or 0 for none.
+  void Trace (SchedulerTrace * trace) { m_trace = trace; }
+#endif
+
+#if defined (SCHEDULER_LOAD_STATS)
+  /// Set length of the load measurement window, milli-seconds.
+  void LoadWindow (uint16_t msec) { m_loadWindow = msec; }
+
+  uint16_t Load() const;
+  uint16_t ChoreLoad (const SchedulerChore * chore) const;
+
+  /// Return time spent running chores in the last window, micro-seconds.
+  uint32_t BusyTime() const { return m_lastBusyTime; }
+
+  /// Return time not spent running chores in the last window, micro-seconds.
+  uint32_t IdleTime() const { return m_lastWindowTime - m_lastBusyTime; }
+#endif
+
+#if defined (SCHEDULER_ADAPTIVE)
+  void AdaptLimits (uint16_t high, uint16_t low);
+
+  /// Return degrade level, zero when keeping up.
+  uint8_t AdaptLevel() const { return m_adaptLevel; }
+
+  /// Return average dispatch lateness, milli-seconds.
+  uint16_t AverageLateness() const { return m_lateAvg >> 4; }
+#endif
 
 protected:
-  int Reschedule (SchedulerChore * chore);
+  int Reschedule (SchedulerChore * chore, SchedulerChore * after = 0);
   uint32_t GetCurrentTime() const;
-  void Insert (SchedulerChore * chore);
+  void Insert (SchedulerChore * chore, SchedulerChore * after = 0);
+  void Complete (SchedulerChore * chore);
+  void Dispatch (SchedulerChore * const * chores, uint8_t count);
+  void TraceEvent (uint8_t reason, SchedulerChore * chore);
+  void UpdateLoad ();
+  void AccountLoad (SchedulerChore * chore, uint32_t run_us);
+  bool UrgentDue (uint8_t priority);
+  void Adapt (int32_t late);
 
 
 private:
-  virtual void Run () { }  // from chore
+  virtual void Run () { RunScheduler(); }  // from chore
 
-  TimerWrap m_timerWrap;
+  friend class SchedulerChore;
+
+  /// Time the millis() clock was stopped while asleep, shared by
+  /// all schedulers, milli-seconds.
+  static uint32_t s_slept;
+
+  /// Queue of pending chores, m_defaultQueue unless changed.
+  SchedulerQueue * m_queue;
+  SortedChoreQueue m_defaultQueue;
 
   uint32_t m_baseTime;
 
+  /// Incremented to orphan all chores at once.
+  uint8_t m_currentEpoch;
+
+  /// Scheduler time when suspended.
+  uint32_t m_suspendTime;
+  bool m_suspended;
+
+  /// Parent we were detached from when suspended.
+  Scheduler * m_owner;
+
+  /// Sleep policy, or 0.
+  PowerPolicy * m_power;
+
+#if defined (SCHEDULER_TRACE)
+  SchedulerTrace * m_trace;
+#endif
+
+#if defined (SCHEDULER_LOAD_STATS)
+  uint16_t m_loadWindow;        // msec
+
+  /// Start of the current window, micro-seconds.
+  uint32_t m_windowStart;
+  uint32_t m_busyTime;          // current window, usec
+  uint32_t m_lastBusyTime;      // last window, usec
+  uint32_t m_lastWindowTime;    // last window length, usec
+  uint8_t m_window;             // window count
+#endif
+
+#if defined (SCHEDULER_ADAPTIVE)
+  /// Average lateness, sixteenths of a milli-second.
+  uint16_t m_lateAvg;
+  uint16_t m_adaptHigh;         // msec
+  uint16_t m_adaptLow;          // msec
+  uint8_t m_adaptLevel;
+
+  /// Time of last change of level, milli-seconds.
+  uint32_t m_adaptTime;
+
+  /// Average lateness and load when the level was last raised
+  /// or held.
+  uint16_t m_adaptLate;
+# if defined (SCHEDULER_LOAD_STATS)
+  uint16_t m_adaptLoad;
+# endif
+#endif
+
   // NON_COPYABLE
   Scheduler (const Scheduler &);
   const Scheduler & operator= (const Scheduler &);
@@ -0,0 +1,182 @@
+/*********************************************************************
+  SchedulerConfig.h - Arduino scheduler build options.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (SchedulerConfig_H_)
+#define SchedulerConfig_H_
+
+//
+// Optional scheduler features.  Each feature costs RAM and time
+// in the dispatch loop, so they are all off by default.  Enable
+// a feature by uncommenting its define here, or by defining it
+// on the compiler command line.
+//
+
+// Fractional chore periods, see SchedulerChore::Period().  Costs
+// six bytes per chore.
+// #define SCHEDULER_FRACTIONAL_PERIODS
+
+// Chore dependencies, see ChoreDependency.  Costs four bytes per
+// chore.
+// #define SCHEDULER_DEPENDENCIES
+
+// Chore batches, see ChoreBatch.  Costs two bytes per chore.
+// #define SCHEDULER_BATCHES
+
+// Chore priorities, see SchedulerChore::Priority().  Costs one
+// byte per chore.
+// #define SCHEDULER_PRIORITY
+
+// Record scheduler events in a SchedulerTrace buffer.
+// #define SCHEDULER_TRACE
+
+// Number of records kept in a SchedulerTrace buffer.
+#if !defined (SCHEDULER_TRACE_SIZE)
+#define SCHEDULER_TRACE_SIZE 32
+#endif
+
+// Measure busy and idle time of the scheduler and its chores.
+// #define SCHEDULER_LOAD_STATS
+
+// Default length of the load measurement window, milli-seconds.
+#if !defined (SCHEDULER_LOAD_WINDOW)
+#define SCHEDULER_LOAD_WINDOW 1000
+#endif
+
+// Route clock reads and chore inputs through a SchedulerLog, so
+// runs can be recorded and replayed.
+// #define SCHEDULER_RECORD
+
+// Reset through the hardware watchdog when a chore hangs, and
+// report the chore after the reset.
+// #define SCHEDULER_WATCHDOG
+
+// Default longest run time of a chore, milli-seconds.
+#if !defined (SCHEDULER_WATCHDOG_TIMEOUT)
+#define SCHEDULER_WATCHDOG_TIMEOUT 1000
+#endif
+
+// Watchdog period, one of the WDTO_ values from <avr/wdt.h>.
+#if !defined (SCHEDULER_WATCHDOG_PERIOD)
+#define SCHEDULER_WATCHDOG_PERIOD WDTO_250MS
+#endif
+
+// Stretch the intervals of low priority AdaptiveChores when the
+// scheduler falls behind.
+// #define SCHEDULER_ADAPTIVE
+
+// Number of steps from the shortest to the longest period of an
+// AdaptiveChore.
+#if !defined (SCHEDULER_ADAPT_STEPS)
+#define SCHEDULER_ADAPT_STEPS 4
+#endif
+
+// Least time between changes of the degrade level, milli-seconds.
+#if !defined (SCHEDULER_ADAPT_HOLD)
+#define SCHEDULER_ADAPT_HOLD 250
+#endif
+
+// Load, in parts per thousand, that raises the degrade level
+// when load is measured.
+#if !defined (SCHEDULER_ADAPT_LOAD)
+#define SCHEDULER_ADAPT_LOAD 900
+#endif
+
+// Highest degrade level, the highest priority of an AdaptiveChore
+// plus SCHEDULER_ADAPT_STEPS.  Levels above it stretch no chore.
+#if !defined (SCHEDULER_ADAPT_MAX_LEVEL)
+#define SCHEDULER_ADAPT_MAX_LEVEL (SCHEDULER_ADAPT_STEPS + 4)
+#endif
+
+// Let AvrPowerPolicy wake from power down with the watchdog
+// timer.  This defines the watchdog interrupt, so it can not be
+// used with SCHEDULER_WATCHDOG.
+// #define SCHEDULER_POWER_WDT
+
+// Time to wake from power down, milli-seconds.
+#if !defined (SCHEDULER_WAKE_LATENCY)
+#define SCHEDULER_WAKE_LATENCY 2
+#endif
+
+// Keep histograms of dispatch lateness and run time for each chore.
+// #define SCHEDULER_HISTOGRAM
+
+// Number of log2 buckets in a LogHistogram.
+#if !defined (SCHEDULER_HISTOGRAM_BUCKETS)
+#define SCHEDULER_HISTOGRAM_BUCKETS 16
+#endif
+
+// Build the IntervalBucketQueue.  Costs two bytes per chore to
+// keep chores that expire together in order.
+// #define SCHEDULER_INTERVAL_QUEUE
+
+// Number of intervals an IntervalBucketQueue keeps separate.
+#if !defined (SCHEDULER_INTERVAL_BUCKETS)
+#define SCHEDULER_INTERVAL_BUCKETS 4
+#endif
+
+// Most chores a ChoreBatch is given in one call.
+#if !defined (SCHEDULER_BATCH_SIZE)
+#define SCHEDULER_BATCH_SIZE 16
+#endif
+
+// Most ports a MultiLEDflasher can drive.
+#if !defined (SCHEDULER_LED_PORTS)
+#define SCHEDULER_LED_PORTS 4
+#endif
+
+// Number of LEDs a PatternSequencer drives.
+#if !defined (SCHEDULER_PWM_CHANNELS)
+#define SCHEDULER_PWM_CHANNELS 4
+#endif
+
+// Length of a software PWM frame, milli-seconds.  A
+// PatternSequencer has one brightness level per milli-second of
+// the frame, plus off.
+#if !defined (SCHEDULER_PWM_FRAME)
+#define SCHEDULER_PWM_FRAME 10
+#endif
+
+// Number of chores a CompactScheduler holds, at most 255.
+#if !defined (SCHEDULER_COMPACT_CHORES)
+#define SCHEDULER_COMPACT_CHORES 32
+#endif
+
+
+// Adaptive chores are degraded in order of priority.
+#if defined (SCHEDULER_ADAPTIVE) && !defined (SCHEDULER_PRIORITY)
+#define SCHEDULER_PRIORITY
+#endif
+
+// Chore run time is measured if any feature needs it.
+#if defined (SCHEDULER_TRACE) || defined (SCHEDULER_LOAD_STATS) \
+  || defined (SCHEDULER_HISTOGRAM)
+#define SCHEDULER_TIME_DISPATCH
+#endif
+
+#if defined (SCHEDULER_POWER_WDT) && defined (SCHEDULER_WATCHDOG)
+#error "SCHEDULER_POWER_WDT and SCHEDULER_WATCHDOG both use the watchdog"
+#endif
+
+#endif	// SchedulerConfig_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
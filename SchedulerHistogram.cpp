@@ -0,0 +1,163 @@
+/*********************************************************************
+  SchedulerHistogram.cpp - Arduino scheduler timing histogram.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "SchedulerHistogram.h"
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * An empty histogram is created.
+ */
+
+LogHistogram::
+LogHistogram()
+{
+  Clear();
+}
+
+
+// ----------------------------------------------------------------------------
+/** Count a value.
+ *
+ * @param[in] val - value to count
+ */
+
+void LogHistogram::
+Add (uint32_t val)
+{
+  if (val > m_max)
+    {
+      m_max = val;
+    }
+
+  // bucket is the number of significant bits
+  uint8_t idx = 0;
+  while (val != 0 && idx < SCHEDULER_HISTOGRAM_BUCKETS - 1)
+    {
+      val >>= 1;
+      ++idx;
+    }
+
+  if (m_counts[idx] == 0xffff)
+    {
+      for (uint8_t i = 0; i < SCHEDULER_HISTOGRAM_BUCKETS; ++i)
+        {
+          m_counts[i] >>= 1;
+        }
+    }
+
+  ++m_counts[idx];
+}
+
+
+// ----------------------------------------------------------------------------
+/** Discard all values.
+ *
+ */
+
+void LogHistogram::
+Clear()
+{
+  for (uint8_t i = 0; i < SCHEDULER_HISTOGRAM_BUCKETS; ++i)
+    {
+      m_counts[i] = 0;
+    }
+
+  m_max = 0;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Get number of values.
+ *
+ * This is the sum of all bucket counts, which is less than the
+ * number of values added once the counts have been halved.
+ */
+
+uint32_t LogHistogram::
+Count() const
+{
+  uint32_t count = 0;
+
+  for (uint8_t i = 0; i < SCHEDULER_HISTOGRAM_BUCKETS; ++i)
+    {
+      count += m_counts[i];
+    }
+
+  return (count);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Get a percentile.
+ *
+ * This method returns a value that is not exceeded by the
+ * specified percentage of the counted values. The value is the
+ * upper limit of the bucket holding the percentile, but never
+ * more than the largest value counted, so Percentile(100)
+ * returns Max().  The last bucket has no upper limit, so a
+ * percentile that falls in it is Max().
+ *
+ * @param[in] pct - percentile, 0 to 100 (50 is the median)
+ *
+ * @return percentile value, or 0 if the histogram is empty.
+ */
+
+uint32_t LogHistogram::
+Percentile (uint8_t pct) const
+{
+  uint32_t count = Count();
+  if (count == 0)
+    {
+      return (0);
+    }
+
+  // number of values at or below the percentile, rounded up
+  uint32_t rank = (count * pct + 99) / 100;
+  if (rank == 0)
+    {
+      rank = 1;
+    }
+
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < SCHEDULER_HISTOGRAM_BUCKETS; ++i)
+    {
+      seen += m_counts[i];
+      if (seen >= rank)
+        {
+          // the last bucket holds everything larger
+          if (i == SCHEDULER_HISTOGRAM_BUCKETS - 1)
+            {
+              return (m_max);
+            }
+
+          uint32_t limit = (i == 0) ? 0 : ((uint32_t) 1 << i) - 1;
+          return (limit < m_max) ? limit : m_max;
+        }
+    } // end for
+
+  return (m_max);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,72 @@
+/*********************************************************************
+  SchedulerHistogram.h - Arduino scheduler timing histogram.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (SchedulerHistogram_H_)
+#define SchedulerHistogram_H_
+
+#include <inttypes.h>
+#include <SchedulerConfig.h>
+
+// ----------------------------------------------------------------------------
+/** Log scale histogram.
+ *
+ * This class counts values in buckets whose width doubles, so a
+ * fixed amount of memory covers values from one to many
+ * thousands. Bucket zero holds the value zero, and bucket k holds
+ * values from 2^(k-1) to 2^k - 1. The last bucket also holds
+ * everything larger. The exact maximum is kept separately.
+ *
+ * When a bucket count would overflow, all counts are halved, so
+ * the histogram keeps its shape and favours recent values.
+ *
+ * The number of buckets is set by SCHEDULER_HISTOGRAM_BUCKETS.
+ */
+
+class LogHistogram
+{
+public:
+  LogHistogram ();
+
+  void Add (uint32_t val);
+  void Clear ();
+
+  /// Return number of values counted.
+  uint32_t Count() const;
+
+  /// Return largest value counted.
+  uint32_t Max() const { return m_max; }
+
+  /// Return count in a bucket.
+  uint16_t Bucket (uint8_t idx) const { return m_counts[idx]; }
+
+  uint32_t Percentile (uint8_t pct) const;
+
+
+private:
+  uint16_t m_counts[SCHEDULER_HISTOGRAM_BUCKETS];
+  uint32_t m_max;
+};
+
+#endif	// SchedulerHistogram_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,454 @@
+/*********************************************************************
+  SchedulerLog.cpp - Arduino scheduler record and replay log.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "SchedulerLog.h"
+#include "WProgram.h"
+
+
+namespace {
+
+//
+// Entry layout: the first byte holds the kind in the top two
+// bits, a continue bit, and the low five bits of the value.  The
+// value continues seven bits per byte, low bits first, while the
+// top bit of a byte is set.  A dispatch entry with a value above
+// the largest chore id repeats the entry before it that many
+// times, less REPEAT_BASE.
+//
+
+const uint8_t VERSION = 2;
+const uint8_t HEADER_SIZE = 5;
+const uint32_t REPEAT_BASE = 0xff;
+const uint8_t NO_ENTRY = 0xff;
+
+
+// Map signed difference to unsigned, small either way.
+inline uint32_t ZigZag (int32_t v)
+{
+  return ((uint32_t) v << 1) ^ (uint32_t) (v >> 31);
+}
+
+inline int32_t UnZigZag (uint32_t v)
+{
+  return (int32_t) (v >> 1) ^ -(int32_t) (v & 1);
+}
+
+} // end namespace
+
+
+SchedulerLog * SchedulerLog::s_log = 0;
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * A log is created that records to a stream.
+ *
+ * @param[in] out - stream to write the log to
+ */
+
+SchedulerLog::
+SchedulerLog (Print & out)
+  : m_out (& out),
+    m_data (0),
+    m_size (0),
+    m_pos (0),
+    m_lastKind (NO_ENTRY),
+    m_lastValue (0),
+    m_repeat (0),
+    m_diverged (false)
+{
+  m_prev[0] = m_prev[1] = 0;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * A log is created that replays a recorded log.  The data is not
+ * copied.
+ *
+ * @param[in] data - recorded log
+ * @param[in] size - number of bytes
+ */
+
+SchedulerLog::
+SchedulerLog (const uint8_t * data, uint32_t size)
+  : m_out (0),
+    m_data (data),
+    m_size (size),
+    m_pos (0),
+    m_lastKind (NO_ENTRY),
+    m_lastValue (0),
+    m_repeat (0),
+    m_diverged (false)
+{
+  m_prev[0] = m_prev[1] = 0;
+
+  if (size < HEADER_SIZE
+      || data[0] != 'S' || data[1] != 'L' || data[2] != 'O' || data[3] != 'G'
+      || data[4] != VERSION)
+    {
+      m_diverged = true;
+      return;
+    }
+
+  m_pos = HEADER_SIZE;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Attach log.
+ *
+ * Values are recorded or replayed through this log from now on.
+ * A recording log writes its header when it is attached.  The
+ * log attached before is flushed.
+ *
+ * @param[in] log - log to use, or 0 for none
+ */
+
+void SchedulerLog::
+Attach (SchedulerLog * log)
+{
+  if (s_log != 0)
+    {
+      s_log->Flush();
+    }
+
+  s_log = log;
+
+  if (log != 0 && log->m_out != 0)
+    {
+      log->m_out->write ((uint8_t) 'S');
+      log->m_out->write ((uint8_t) 'L');
+      log->m_out->write ((uint8_t) 'O');
+      log->m_out->write ((uint8_t) 'G');
+      log->m_out->write (VERSION);
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Write repeats not yet written.
+ *
+ * A recording log holds back repeats of its last entry until a
+ * different entry is logged.  Call this before the stream is
+ * closed or the board is reset, so the tail of the log is not
+ * lost.
+ */
+
+void SchedulerLog::
+Flush ()
+{
+  if (m_out == 0 || m_repeat == 0)
+    {
+      return;
+    }
+
+  // a single repeat is no longer written out again
+  if (m_repeat == 1)
+    {
+      Encode (m_lastKind, m_lastValue);
+    }
+  else
+    {
+      Encode (LOG_DISPATCH, REPEAT_BASE + m_repeat);
+    }
+
+  m_repeat = 0;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Read scheduler time through the log.
+ *
+ * @param[in] live - time read from the clock
+ * @return time to use.
+ */
+
+uint32_t SchedulerLog::
+Time (uint32_t live)
+{
+  return (s_log != 0) ? s_log->Log (LOG_TIME, live) : live;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Read micro-second clock through the log.
+ *
+ * @param[in] live - time read from the clock
+ * @return time to use.
+ */
+
+uint32_t SchedulerLog::
+Micros (uint32_t live)
+{
+  return (s_log != 0) ? s_log->Log (LOG_MICROS, live) : live;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Read external value through the log.
+ *
+ * Chores call this for every value they read from outside, such
+ * as pins, sensors and serial input, so it is replayed.
+ *
+ * @param[in] live - value read
+ * @return value to use.
+ */
+
+uint32_t SchedulerLog::
+Input (uint32_t live)
+{
+  return (s_log != 0) ? s_log->Log (LOG_INPUT, live) : live;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Log dispatch of a chore.
+ *
+ * @param[in] id - id of the chore
+ */
+
+void SchedulerLog::
+Dispatched (uint8_t id)
+{
+  if (s_log != 0)
+    {
+      s_log->Log (LOG_DISPATCH, id);
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Record or replay a value.
+ *
+ * @param[in] kind - kind of value
+ * @param[in] live - live value
+ * @return value to use.
+ */
+
+uint32_t SchedulerLog::
+Log (uint8_t kind, uint32_t live)
+{
+  if (m_out != 0)
+    {
+      Write (kind, live);
+      return (live);
+    }
+
+  if (m_diverged || AtEnd())
+    {
+      return (live);
+    }
+
+  uint32_t pos = m_pos;
+  uint16_t repeat = m_repeat;
+  uint8_t got_kind;
+  uint32_t value;
+
+  if (! Read (got_kind, value) || got_kind != kind
+      || (kind == LOG_DISPATCH && value != live))
+    {
+      m_diverged = true;
+      m_pos = pos;
+      m_repeat = repeat;
+      return (live);
+    }
+
+  return (value);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Write an entry.
+ *
+ * An entry that is the same as the last one written is counted
+ * instead.
+ *
+ * @param[in] kind - kind of value
+ * @param[in] value - value
+ */
+
+void SchedulerLog::
+Write (uint8_t kind, uint32_t value)
+{
+  if (kind == LOG_TIME || kind == LOG_MICROS)
+    {
+      uint32_t diff = value - m_prev[kind];
+      m_prev[kind] = value;
+      value = ZigZag ((int32_t) diff);
+    }
+
+  if (kind == m_lastKind && value == m_lastValue && m_repeat < 0xffff)
+    {
+      ++m_repeat;
+      return;
+    }
+
+  Flush();
+  Encode (kind, value);
+
+  m_lastKind = kind;
+  m_lastValue = value;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Write the bytes of an entry.
+ *
+ * @param[in] kind - kind of value
+ * @param[in] value - value, as encoded
+ */
+
+void SchedulerLog::
+Encode (uint8_t kind, uint32_t value)
+{
+  uint8_t byte = (kind << 6) | (value & 0x1f);
+  value >>= 5;
+  if (value != 0)
+    {
+      byte |= 0x20;
+    }
+  m_out->write (byte);
+
+  while (value != 0)
+    {
+      byte = value & 0x7f;
+      value >>= 7;
+      if (value != 0)
+        {
+          byte |= 0x80;
+        }
+      m_out->write (byte);
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Read next entry of a replay log.
+ *
+ * Clock values are returned as absolute values, and repeated
+ * entries are returned once for each repeat.
+ *
+ * @param[out] kind - kind of value
+ * @param[out] value - value
+ * @return true if an entry was read, false at the end of the log
+ * or if the entry is cut short or corrupt.
+ */
+
+bool SchedulerLog::
+Read (uint8_t & kind, uint32_t & value)
+{
+  if (m_data == 0 || AtEnd())
+    {
+      return (false);
+    }
+
+  if (m_repeat != 0)
+    {
+      --m_repeat;
+    }
+  else
+    {
+      if (! Decode (kind, value))
+        {
+          return (false);
+        }
+
+      if (kind == LOG_DISPATCH && value > REPEAT_BASE)
+        {
+          // a repeat with nothing to repeat is corrupt
+          if (m_lastKind == NO_ENTRY || value - REPEAT_BASE > 0xffff)
+            {
+              return (false);
+            }
+
+          m_repeat = value - REPEAT_BASE - 1;
+        }
+      else
+        {
+          m_lastKind = kind;
+          m_lastValue = value;
+        }
+    }
+
+  kind = m_lastKind;
+  value = m_lastValue;
+
+  if (kind == LOG_TIME || kind == LOG_MICROS)
+    {
+      m_prev[kind] += UnZigZag (value);
+      value = m_prev[kind];
+    }
+
+  return (true);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Read the bytes of an entry.
+ *
+ * A value is at most 32 bits, so it takes at most five bytes.
+ *
+ * @param[out] kind - kind of value
+ * @param[out] value - value, as encoded
+ * @return true if an entry was read, false if it is cut short
+ * or longer than 32 bits.
+ */
+
+bool SchedulerLog::
+Decode (uint8_t & kind, uint32_t & value)
+{
+  uint8_t byte = m_data[m_pos++];
+
+  kind = byte >> 6;
+  value = byte & 0x1f;
+
+  uint8_t shift = 5;
+  bool more = (byte & 0x20) != 0;
+
+  while (more)
+    {
+      if (m_pos >= m_size || shift >= 32)
+        {
+          return (false);
+        }
+
+      byte = m_data[m_pos++];
+
+      uint32_t bits = byte & 0x7f;
+      if (((bits << shift) >> shift) != bits)
+        {
+          return (false); // more than 32 bits
+        }
+
+      value |= bits << shift;
+      shift += 7;
+      more = (byte & 0x80) != 0;
+    }
+
+  return (true);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,154 @@
+/*********************************************************************
+  SchedulerLog.h - Arduino scheduler record and replay log.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (SchedulerLog_H_)
+#define SchedulerLog_H_
+
+#include <inttypes.h>
+#include <SchedulerConfig.h>
+
+class Print;
+
+
+// ----------------------------------------------------------------------------
+/** Scheduler record and replay log.
+ *
+ * This class records everything that makes a scheduler run
+ * differ from one run to the next, so the run can be replayed
+ * exactly on a host.  When SCHEDULER_RECORD is defined in
+ * SchedulerConfig.h, every read of the scheduler clock (and of
+ * the micro-second clock, when dispatches are timed) goes through
+ * the attached log, and so do external values that chores read
+ * through Input().  The id of each dispatched chore is logged as
+ * well, as a check.
+ *
+ * When recording, the values are streamed to a Print as they
+ * change.  Each entry is a kind and a variable length number, and
+ * clock reads are logged as the difference from the previous
+ * read, so most entries are one byte.  An entry that is the same
+ * as the one before, such as a clock read in the same
+ * milli-second, is only counted, and the count is written as a
+ * repeat entry when a different entry is logged or the log is
+ * flushed.  The stream starts with a four byte "SLOG" marker and
+ * a version byte.
+ *
+ * When replaying, the values are read back from a buffer instead
+ * of the clocks and inputs, so the same chores, built on the host,
+ * are dispatched in the same order with the same times.  If the
+ * replay reads a value of a different kind than was recorded, or
+ * dispatches a different chore, the run has diverged; Diverged()
+ * is set and the live values are used from then on.
+ *
+ * Example:
+\code
+// on the device
+SchedulerLog  the_log (Serial);
+SchedulerLog::Attach (& the_log);
+
+// in a chore
+uint16_t level = SchedulerLog::Input (analogRead (0));
+
+// on the host, with the recorded bytes
+SchedulerLog  replay (data, size);
+SchedulerLog::Attach (& replay);
+while (! replay.AtEnd() && ! replay.Diverged())
+  {
+    the_scheduler.RunScheduler();
+  }
+\endcode
+ */
+
+class SchedulerLog
+{
+public:
+  /// Kinds of log entries.
+  enum Kind
+    {
+      LOG_TIME = 0,       ///< scheduler time read, milli-seconds
+      LOG_MICROS,         ///< micro-second clock read
+      LOG_INPUT,          ///< external value read by a chore
+      LOG_DISPATCH        ///< chore id dispatched
+    };
+
+  SchedulerLog (Print & out);
+  SchedulerLog (const uint8_t * data, uint32_t size);
+
+  static void Attach (SchedulerLog * log);
+  void Flush ();
+
+  /// Return log attached, or 0.
+  static SchedulerLog * Attached() { return s_log; }
+
+  static uint32_t Time (uint32_t live);
+  static uint32_t Micros (uint32_t live);
+  static uint32_t Input (uint32_t live);
+  static void Dispatched (uint8_t id);
+
+  bool Read (uint8_t & kind, uint32_t & value);
+
+  /// Return true if replaying.
+  bool IsReplaying() const { return (m_data != 0); }
+
+  /// Return true if all entries have been replayed.
+  bool AtEnd() const { return (m_pos >= m_size && m_repeat == 0); }
+
+  /// Return true if the replay did not follow the log.
+  bool Diverged() const { return m_diverged; }
+
+  /// Return offset of next entry in the log.
+  uint32_t Position() const { return m_pos; }
+
+
+private:
+  uint32_t Log (uint8_t kind, uint32_t live);
+  void Write (uint8_t kind, uint32_t value);
+  void Encode (uint8_t kind, uint32_t value);
+  bool Decode (uint8_t & kind, uint32_t & value);
+
+  static SchedulerLog * s_log;
+
+  Print * m_out;
+  const uint8_t * m_data;
+  uint32_t m_size;
+  uint32_t m_pos;
+
+  /// Previous clock values, for the differences.
+  uint32_t m_prev[2];
+
+  /// Last entry written or read, as encoded, for repeats.
+  uint8_t m_lastKind;
+  uint32_t m_lastValue;
+
+  /// Repeats of the last entry not yet written, or not yet read.
+  uint16_t m_repeat;
+
+  bool m_diverged;
+
+  // NON_COPYABLE
+  SchedulerLog (const SchedulerLog &);
+  const SchedulerLog & operator= (const SchedulerLog &);
+};
+
+#endif	// SchedulerLog_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,159 @@
+/*********************************************************************
+  SchedulerTrace.cpp - Arduino scheduler event trace.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "SchedulerTrace.h"
+#include "WProgram.h"
+
+
+namespace {
+
+// ----------------------------------------------------------------------------
+/** Write value to output, least significant byte first.
+ */
+
+void
+WriteLE (Print & out, uint32_t val, uint8_t size)
+{
+  for (uint8_t i = 0; i < size; ++i)
+    {
+      out.write ((uint8_t) (val & 0xff));
+      val >>= 8;
+    }
+}
+
+} // end namespace
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * An empty trace is created.
+ */
+
+SchedulerTrace::
+SchedulerTrace()
+  : m_next (0),
+    m_count (0)
+{
+
+}
+
+
+// ----------------------------------------------------------------------------
+/** Record an event.
+ *
+ * This method adds an event to the trace, replacing the oldest
+ * record if the trace is full.
+ *
+ * @param[in] reason - what happened, from SchedulerTraceRecord::Reason
+ * @param[in] chore - id of the chore
+ * @param[in] target - chore target time, milli-seconds
+ * @param[in] start - scheduler time of the event, milli-seconds
+ * @param[in] duration - chore run time, micro-seconds
+ */
+
+void SchedulerTrace::
+Record (uint8_t reason, uint8_t chore, uint32_t target,
+        uint32_t start, uint32_t duration)
+{
+  SchedulerTraceRecord & rec = m_records[m_next];
+
+  rec.m_chore = chore;
+  rec.m_reason = reason;
+  rec.m_duration = (duration > 0xffff) ? 0xffff : (uint16_t) duration;
+  rec.m_target = target;
+  rec.m_start = start;
+
+  if (++m_next == SCHEDULER_TRACE_SIZE)
+    {
+      m_next = 0;
+    }
+
+  if (m_count < SCHEDULER_TRACE_SIZE)
+    {
+      ++m_count;
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Get a record.
+ *
+ * @param[in] idx - record index, zero is the oldest record.
+ */
+
+const SchedulerTraceRecord & SchedulerTrace::
+operator[] (uint16_t idx) const
+{
+  uint16_t slot = m_next + SCHEDULER_TRACE_SIZE - m_count + idx;
+
+  return m_records[slot % SCHEDULER_TRACE_SIZE];
+}
+
+
+// ----------------------------------------------------------------------------
+/** Discard all records.
+ *
+ */
+
+void SchedulerTrace::
+Clear()
+{
+  m_next = 0;
+  m_count = 0;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Write trace in binary form.
+ *
+ * This method writes the header and all records, oldest first,
+ * to the specified output, usually Serial.
+ *
+ * @param[in] out - stream to write to
+ */
+
+void SchedulerTrace::
+Dump (Print & out) const
+{
+  out.write ((uint8_t) 'S');
+  out.write ((uint8_t) 'T');
+  out.write ((uint8_t) 'R');
+  out.write ((uint8_t) 'C');
+  out.write ((uint8_t) 1); // version
+  out.write ((uint8_t) 12); // record size
+  WriteLE (out, m_count, 2);
+
+  for (uint16_t i = 0; i < m_count; ++i)
+    {
+      const SchedulerTraceRecord & rec = (*this)[i];
+
+      out.write (rec.m_chore);
+      out.write (rec.m_reason);
+      WriteLE (out, rec.m_duration, 2);
+      WriteLE (out, rec.m_target, 4);
+      WriteLE (out, rec.m_start, 4);
+    } // end for
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,123 @@
+/*********************************************************************
+  SchedulerTrace.h - Arduino scheduler event trace.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (SchedulerTrace_H_)
+#define SchedulerTrace_H_
+
+#include <inttypes.h>
+#include <SchedulerConfig.h>
+
+class Print;
+
+
+// ----------------------------------------------------------------------------
+/** Scheduler trace record.
+ *
+ * One scheduler event. Records are stored and dumped in this
+ * layout, least significant byte first, 12 bytes each.
+ */
+
+struct SchedulerTraceRecord
+{
+  enum Reason
+    {
+      DISPATCH = 0,   ///< chore was run
+      SCHEDULE,       ///< chore was scheduled
+      RESCHEDULE,     ///< chore was rescheduled after running
+      ABORT,          ///< chore was aborted
+      TRIGGER         ///< chore was triggered
+    };
+
+  uint8_t  m_chore;     ///< chore id
+  uint8_t  m_reason;    ///< what happened, from Reason
+  uint16_t m_duration;  ///< run time in micro-seconds, saturated
+  uint32_t m_target;    ///< chore target time, milli-seconds
+  uint32_t m_start;     ///< scheduler time of the event, milli-seconds
+};
+
+
+// ----------------------------------------------------------------------------
+/** Scheduler event trace.
+ *
+ * This class is a ring buffer of the most recent scheduler
+ * events. A scheduler records into the trace that is attached to
+ * it with Scheduler::Trace(). When the buffer is full, the oldest
+ * record is overwritten.
+ *
+ * The trace is only recorded when SCHEDULER_TRACE is defined in
+ * SchedulerConfig.h. The size of the buffer is set by
+ * SCHEDULER_TRACE_SIZE.
+ *
+ * Dump() writes the records as a compact binary block, which can
+ * be converted on the host to a Chrome trace (Perfetto) timeline
+ * with extras/trace2json.py.  The block is a four byte "STRC"
+ * marker, a version byte, the record size byte, a two byte record
+ * count, and then the records oldest first.
+ *
+ * Example:
+\code
+SchedulerTrace  the_trace;
+
+void setup()
+{
+  the_scheduler.Trace (& the_trace);
+}
+
+// when something went wrong
+the_trace.Dump (Serial);
+\endcode
+ */
+
+class SchedulerTrace
+{
+public:
+  SchedulerTrace ();
+
+  void Record (uint8_t reason, uint8_t chore, uint32_t target,
+               uint32_t start, uint32_t duration = 0);
+
+  /// Return number of records in the trace.
+  uint16_t Count() const { return m_count; }
+
+  /// Return record, with zero being the oldest.
+  const SchedulerTraceRecord & operator[] (uint16_t idx) const;
+
+  void Clear();
+  void Dump (Print & out) const;
+
+
+private:
+  SchedulerTraceRecord m_records[SCHEDULER_TRACE_SIZE];
+
+  /// Index of next record to write
+  uint16_t m_next;
+  uint16_t m_count;
+
+  // NON_COPYABLE
+  SchedulerTrace (const SchedulerTrace &);
+  const SchedulerTrace & operator= (const SchedulerTrace &);
+};
+
+#endif	// SchedulerTrace_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
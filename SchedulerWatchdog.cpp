@@ -0,0 +1,322 @@
+/*********************************************************************
+  SchedulerWatchdog.cpp - hung chore detection for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "SchedulerWatchdog.h"
+
+#if defined (SCHEDULER_WATCHDOG)
+
+#include "WProgram.h"
+
+#if defined (__AVR__)
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+#endif
+
+
+namespace {
+
+const uint16_t SLOT_MAGIC = 0x5744;
+
+// The slot is not cleared at start up, so it still holds the
+// chore that was running when the watchdog reset the board.
+#if defined (__AVR__)
+volatile SchedulerWatchdogSlot s_slot __attribute__ ((section (".noinit")));
+#else
+volatile SchedulerWatchdogSlot s_slot;
+#endif
+
+
+// ------------------------------------------------------------------
+/** Write number in decimal.
+ *
+ */
+
+void
+WriteDecimal (Print & out, uint32_t val)
+{
+  char buf[10];
+  uint8_t len = 0;
+
+  do
+    {
+      buf[len++] = '0' + (val % 10);
+      val /= 10;
+    }
+  while (val != 0);
+
+  while (len > 0)
+    {
+      out.write ((uint8_t) buf[--len]);
+    }
+}
+
+
+// ------------------------------------------------------------------
+/** Write string.
+ *
+ */
+
+void
+WriteString (Print & out, const char * str)
+{
+  while (*str != 0)
+    {
+      out.write ((uint8_t) *str++);
+    }
+}
+
+} // end namespace
+
+
+bool SchedulerWatchdog::s_culprit = false;
+uint8_t SchedulerWatchdog::s_culpritId = 0;
+uint32_t SchedulerWatchdog::s_culpritElapsed = 0;
+volatile uint32_t SchedulerWatchdog::s_kicked = 0;
+
+
+// ----------------------------------------------------------------------------
+/** Start the watchdog.
+ *
+ * This method should be called once from setup().  If the last
+ * reset came while a chore was running, that chore is saved for
+ * Culprit() and Report().  The slot is then cleared and the
+ * watchdog started.
+ */
+
+void SchedulerWatchdog::
+Begin()
+{
+#if defined (__AVR__)
+  // A watchdog reset leaves the watchdog running, at its
+  // shortest period.
+  MCUSR = 0;
+  wdt_disable();
+#endif
+
+  s_culprit = (s_slot.m_magic == SLOT_MAGIC && s_slot.m_running != 0);
+  if (s_culprit)
+    {
+      s_culpritId = s_slot.m_chore;
+      s_culpritElapsed = s_slot.m_elapsed;
+    }
+
+  s_slot.m_running = 0;
+  s_slot.m_chore = 0;
+  s_slot.m_limit = 0;
+  s_slot.m_start = 0;
+  s_slot.m_elapsed = 0;
+  s_slot.m_magic = SLOT_MAGIC;
+
+  s_kicked = millis();
+
+#if defined (__AVR__)
+  uint8_t sreg = SREG;
+  cli();
+  wdt_enable (SCHEDULER_WATCHDOG_PERIOD);
+# if defined (WDTCSR) && defined (WDIE)
+  WDTCSR |= _BV(WDIE);
+# endif
+  SREG = sreg;
+#endif
+}
+
+
+// ----------------------------------------------------------------------------
+/** Get chore that caused the last reset.
+ *
+ * @param[out] id - id of chore that was running
+ * @param[out] elapsed - time it had run when last checked,
+ * milli-seconds
+ * @retval true - the last reset came while a chore was running
+ * @retval false - no chore was running
+ */
+
+bool SchedulerWatchdog::
+Culprit (uint8_t & id, uint32_t & elapsed)
+{
+  if (s_culprit)
+    {
+      id = s_culpritId;
+      elapsed = s_culpritElapsed;
+    }
+
+  return (s_culprit);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Write report of the last reset.
+ *
+ * A line of text naming the chore that was running when the
+ * board was reset, and for how long, is written to the specified
+ * output, usually Serial.  Nothing is written if no chore was
+ * running.
+ *
+ * @param[in] out - stream to write to
+ */
+
+void SchedulerWatchdog::
+Report (Print & out)
+{
+  if (! s_culprit)
+    {
+      return;
+    }
+
+  WriteString (out, "watchdog reset in chore ");
+  WriteDecimal (out, s_culpritId);
+  WriteString (out, " after ");
+  WriteDecimal (out, s_culpritElapsed);
+  WriteString (out, " ms\r\n");
+}
+
+
+// ----------------------------------------------------------------------------
+/** Kick the watchdog.
+ *
+ * The scheduler calls this after each chore returns and on each
+ * pass of RunScheduler().
+ */
+
+void SchedulerWatchdog::
+Kick()
+{
+  uint32_t now = millis();
+
+#if defined (__AVR__)
+  uint8_t sreg = SREG;
+  cli();
+  s_kicked = now;
+  wdt_reset();
+  SREG = sreg;
+#else
+  s_kicked = now;
+#endif
+}
+
+
+// ----------------------------------------------------------------------------
+/** Check the running chore.
+ *
+ * This method is called from the watchdog interrupt.  The run
+ * time of the current chore is updated in the slot.  If the chore
+ * is past its limit, or if no chore is running and the watchdog
+ * has not been kicked for SCHEDULER_WATCHDOG_TIMEOUT, the
+ * interrupt is left off so the next watchdog period resets the
+ * board.
+ *
+ * @retval true - the board is about to be reset
+ * @retval false - all is well
+ */
+
+bool SchedulerWatchdog::
+Check()
+{
+  uint32_t now = millis();
+  bool expired;
+
+  if (s_slot.m_running != 0)
+    {
+      s_slot.m_elapsed = now - s_slot.m_start;
+      expired = (s_slot.m_limit != 0 && s_slot.m_elapsed >= s_slot.m_limit);
+    }
+  else
+    {
+      expired = (now - s_kicked >= SCHEDULER_WATCHDOG_TIMEOUT);
+    }
+
+#if defined (__AVR__) && defined (WDTCSR) && defined (WDIE)
+  if (! expired)
+    {
+      WDTCSR |= _BV(WDIE);
+    }
+#endif
+
+  return (expired);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Record chore about to run.
+ *
+ * The chore is written to the slot.  The slot that was there is
+ * returned, so a scheduler run from inside a chore gives it back
+ * when its own chore returns.
+ *
+ * @param[in] id - id of chore
+ * @param[in] limit - longest run time, milli-seconds, 0 for none
+ * @param[out] saved - previous slot, for Leave()
+ */
+
+void SchedulerWatchdog::
+Enter (uint8_t id, uint16_t limit, SchedulerWatchdogSlot & saved)
+{
+  saved.m_chore = s_slot.m_chore;
+  saved.m_running = s_slot.m_running;
+  saved.m_limit = s_slot.m_limit;
+  saved.m_start = s_slot.m_start;
+  saved.m_elapsed = s_slot.m_elapsed;
+
+  // Clear running first, so the interrupt never sees half a slot.
+  s_slot.m_running = 0;
+  s_slot.m_chore = id;
+  s_slot.m_limit = limit;
+  s_slot.m_start = millis();
+  s_slot.m_elapsed = 0;
+  s_slot.m_running = 1;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Record chore returned.
+ *
+ * The slot from before Enter() is put back and the watchdog is
+ * kicked.
+ *
+ * @param[in] saved - slot returned by Enter()
+ */
+
+void SchedulerWatchdog::
+Leave (const SchedulerWatchdogSlot & saved)
+{
+  s_slot.m_running = 0;
+  s_slot.m_chore = saved.m_chore;
+  s_slot.m_limit = saved.m_limit;
+  s_slot.m_start = saved.m_start;
+  s_slot.m_elapsed = saved.m_elapsed;
+  s_slot.m_running = saved.m_running;
+
+  Kick();
+}
+
+
+#if defined (__AVR__) && defined (WDT_vect)
+ISR (WDT_vect)
+{
+  SchedulerWatchdog::Check();
+}
+#endif
+
+#endif	// SCHEDULER_WATCHDOG
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
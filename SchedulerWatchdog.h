@@ -0,0 +1,121 @@
+/*********************************************************************
+  SchedulerWatchdog.h - hung chore detection for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (SchedulerWatchdog_H_)
+#define SchedulerWatchdog_H_
+
+#include <inttypes.h>
+#include <SchedulerConfig.h>
+
+class Print;
+
+
+// ----------------------------------------------------------------------------
+/** Watchdog slot.
+ *
+ * The chore being run, kept in memory that is not cleared by a
+ * reset, so it can be reported after the watchdog fires.
+ */
+
+struct SchedulerWatchdogSlot
+{
+  uint16_t m_magic;     ///< marks a valid slot
+  uint8_t  m_chore;     ///< id of chore running
+  uint8_t  m_running;   ///< non-zero while the chore runs
+  uint16_t m_limit;     ///< longest run time, milli-seconds, 0 for none
+  uint32_t m_start;     ///< time the chore was started, milli-seconds
+  uint32_t m_elapsed;   ///< run time last seen, milli-seconds
+};
+
+
+// ----------------------------------------------------------------------------
+/** Scheduler watchdog.
+ *
+ * This class uses the hardware watchdog to reset the board when a
+ * chore runs too long, and tells which chore it was after the
+ * reset.  When SCHEDULER_WATCHDOG is defined in SchedulerConfig.h,
+ * the scheduler writes the id of each chore into a slot that
+ * survives the reset before running it, and kicks the watchdog
+ * when the chore returns.
+ *
+ * The watchdog is run in interrupt and reset mode.  Each
+ * watchdog period the interrupt checks how long the current
+ * chore has run.  If it is past the chore's limit (see
+ * SchedulerChore::MaxRunTime()), the interrupt is not re-armed
+ * and the next period resets the board.  Otherwise a chore may
+ * run for several watchdog periods.  A chore that hangs with
+ * interrupts off is reset after two periods, and RunScheduler()
+ * must be called at least every SCHEDULER_WATCHDOG_TIMEOUT
+ * milli-seconds between chores.  On parts without a watchdog
+ * interrupt, the watchdog only resets, after one period.
+ *
+ * The watchdog period is set by SCHEDULER_WATCHDOG_PERIOD in
+ * SchedulerConfig.h, as one of the WDTO_ values from <avr/wdt.h>.
+ * Limits are checked to the nearest period.
+ *
+ * Example:
+\code
+void setup()
+{
+  Serial.begin (9600);
+  SchedulerWatchdog::Begin();
+
+  uint8_t id;
+  uint32_t elapsed;
+  if (SchedulerWatchdog::Culprit (id, elapsed))
+    {
+      SchedulerWatchdog::Report (Serial);
+    }
+
+  slow_chore.MaxRunTime (5000);
+}
+\endcode
+ */
+
+class SchedulerWatchdog
+{
+public:
+  static void Begin();
+
+  static bool Culprit (uint8_t & id, uint32_t & elapsed);
+  static void Report (Print & out);
+
+  static void Kick();
+  static bool Check();
+
+  static void Enter (uint8_t id, uint16_t limit, SchedulerWatchdogSlot & saved);
+  static void Leave (const SchedulerWatchdogSlot & saved);
+
+
+private:
+  static bool s_culprit;
+  static uint8_t s_culpritId;
+  static uint32_t s_culpritElapsed;
+
+  /// Time of last kick, milli-seconds.
+  static volatile uint32_t s_kicked;
+};
+
+#endif	// SchedulerWatchdog_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,269 @@
+/*********************************************************************
+  StaticSchedule.h - compile time cyclic schedule for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (StaticSchedule_H_)
+#define StaticSchedule_H_
+
+#if __cplusplus < 201103L
+#error "StaticSchedule.h needs C++11"
+#endif
+
+#include <Scheduler.h>
+
+#if defined (__AVR__)
+#include <avr/pgmspace.h>
+#endif
+
+
+// ------------------------------------------------------------------
+/** Periodic task of a static schedule.
+ *
+ * @param P - period, milli-seconds
+ * @param PH - phase, milli-seconds after the start of the cycle
+ * @param W - worst case run time, micro-seconds, or 0 if unknown
+ */
+
+template < uint16_t P, uint16_t PH = 0, uint32_t W = 0 >
+struct Periodic
+{
+  static constexpr uint16_t period = P;
+  static constexpr uint16_t phase = PH;
+  static constexpr uint32_t wcet = W;
+
+  static_assert (P > 0, "period must not be zero");
+  static_assert (PH < P, "phase must be less than the period");
+};
+
+
+namespace StaticScheduleDetail {
+
+constexpr uint32_t Gcd (uint32_t a, uint32_t b)
+{
+  return (b == 0) ? a : Gcd (b, a % b);
+}
+
+constexpr uint32_t Lcm (uint32_t a, uint32_t b)
+{
+  return a / Gcd (a, b) * b;
+}
+
+constexpr uint32_t Max (uint32_t a, uint32_t b)
+{
+  return (a > b) ? a : b;
+}
+
+
+// Index sequence, built by halves so the depth is log2(N).
+template < uint16_t... I > struct Indexes { };
+
+template < class A, class B > struct Concat;
+
+template < uint16_t... I, uint16_t... J >
+struct Concat < Indexes < I... >, Indexes < J... > >
+{
+  typedef Indexes < I..., (sizeof... (I) + J)... > type;
+};
+
+template < uint16_t N >
+struct MakeIndexes
+  : Concat < typename MakeIndexes < N / 2 >::type,
+             typename MakeIndexes < N - N / 2 >::type >
+{ };
+
+template <> struct MakeIndexes < 0 > { typedef Indexes <> type; };
+template <> struct MakeIndexes < 1 > { typedef Indexes < 0 > type; };
+
+
+// Properties of a list of tasks at a given time.
+template < class... T > struct Tasks;
+
+template <>
+struct Tasks <>
+{
+  static constexpr uint32_t Hyperperiod() { return 1; }
+  static constexpr bool Aligned (uint16_t) { return true; }
+  static constexpr uint32_t Mask (uint32_t, uint8_t) { return 0; }
+  static constexpr uint32_t Load (uint32_t) { return 0; }
+};
+
+template < class T, class... R >
+struct Tasks < T, R... >
+{
+  static constexpr bool Due (uint32_t t)
+  {
+    return (t % T::period) == T::phase;
+  }
+
+  static constexpr uint32_t Hyperperiod()
+  {
+    return Lcm (T::period, Tasks < R... >::Hyperperiod());
+  }
+
+  static constexpr bool Aligned (uint16_t minor)
+  {
+    return (T::period % minor) == 0 && (T::phase % minor) == 0
+      && Tasks < R... >::Aligned (minor);
+  }
+
+  // bit of each task that is due at time t
+  static constexpr uint32_t Mask (uint32_t t, uint8_t bit)
+  {
+    return (Due (t) ? (1UL << bit) : 0) | Tasks < R... >::Mask (t, bit + 1);
+  }
+
+  // run time of tasks that are due at time t
+  static constexpr uint32_t Load (uint32_t t)
+  {
+    return (Due (t) ? T::wcet : 0) + Tasks < R... >::Load (t);
+  }
+};
+
+
+// Largest load of the slots in [lo, hi), by halves.
+template < uint16_t MINOR, class... T >
+constexpr uint32_t MaxLoad (uint32_t lo, uint32_t hi)
+{
+  return (hi - lo == 1) ? Tasks < T... >::Load (lo * MINOR)
+    : Max (MaxLoad < MINOR, T... > (lo, (lo + hi) / 2),
+           MaxLoad < MINOR, T... > ((lo + hi) / 2, hi));
+}
+
+
+// Table of task masks, one for each slot.
+template < uint16_t MINOR, class S, class... T > struct SlotTable;
+
+template < uint16_t MINOR, uint16_t... I, class... T >
+struct SlotTable < MINOR, Indexes < I... >, T... >
+{
+  static const uint32_t s_mask[sizeof... (I)];
+};
+
+template < uint16_t MINOR, uint16_t... I, class... T >
+const uint32_t SlotTable < MINOR, Indexes < I... >, T... >::s_mask[sizeof... (I)]
+#if defined (__AVR__)
+  PROGMEM
+#endif
+  = { Tasks < T... >::Mask ((uint32_t) I * MINOR, 0)... };
+
+} // end namespace
+
+
+// ------------------------------------------------------------------
+/** Static cyclic schedule.
+ *
+ * This chore runs a fixed set of periodic chores from a table
+ * that is computed when the program is compiled.  The table has
+ * one entry for each minor frame of the hyperperiod (the least
+ * common multiple of the periods), holding a bit for each chore
+ * that is due in that frame.  Each time this chore runs, it looks
+ * up the current frame and runs the chores by index, so there is
+ * no queue to maintain and no sorting.
+ *
+ * This chore is scheduled with the minor frame as its interval.
+ * The chores in the table are not scheduled themselves.  All
+ * periods and phases must be multiples of the minor frame.
+ *
+ * When worst case run times are given, the compiler checks that
+ * the chores due in any frame fit in the frame.  On AVR the table
+ * is kept in program memory.
+ *
+ * Example:
+\code
+StaticSchedule < 10,
+                 Periodic < 10 >,
+                 Periodic < 50, 0, 2000 >,
+                 Periodic < 100, 20 > >  the_cycle (sensor, filter, display);
+
+the_scheduler.Schedule (& the_cycle);
+\endcode
+ *
+ * @param MINOR - minor frame, milli-seconds
+ * @param T - a Periodic for each chore, in the order of the chores
+ */
+
+template < uint16_t MINOR, class... T >
+class StaticSchedule
+  : public SchedulerChore
+{
+  typedef StaticScheduleDetail::Tasks < T... > TaskList;
+
+public:
+  static constexpr uint8_t CHORES = sizeof... (T);
+  static constexpr uint32_t HYPERPERIOD = TaskList::Hyperperiod();
+  static constexpr uint32_t SLOTS = HYPERPERIOD / MINOR;
+
+  static_assert (MINOR > 0, "minor frame must not be zero");
+  static_assert (CHORES > 0 && CHORES <= 32, "1 to 32 chores");
+  static_assert (TaskList::Aligned (MINOR),
+                 "periods and phases must be multiples of the minor frame");
+  static_assert (SLOTS <= 0xffff, "hyperperiod has too many minor frames");
+  static_assert (StaticScheduleDetail::MaxLoad < MINOR, T... > (0, SLOTS)
+                 <= (uint32_t) MINOR * 1000,
+                 "chores due in a minor frame run longer than the frame");
+
+  template < class... C >
+  StaticSchedule (C &... chores)
+    : SchedulerChore (MINOR),
+      m_chores { & chores... },
+      m_slot (0)
+  {
+    static_assert (sizeof... (C) == CHORES, "one chore for each Periodic");
+  }
+
+  /// Return minor frame that runs next.
+  uint16_t Slot() const { return m_slot; }
+
+
+private:
+  typedef StaticScheduleDetail::SlotTable <
+    MINOR, typename StaticScheduleDetail::MakeIndexes < SLOTS >::type, T... > Table;
+
+  virtual void Run()
+  {
+#if defined (__AVR__)
+    uint32_t mask = pgm_read_dword (& Table::s_mask[m_slot]);
+#else
+    uint32_t mask = Table::s_mask[m_slot];
+#endif
+
+    for (uint8_t i = 0; mask != 0; ++i, mask >>= 1)
+      {
+        if (mask & 1)
+          {
+            RunChore (m_chores[i]);
+          }
+      }
+
+    if (++m_slot == SLOTS)
+      {
+        m_slot = 0;
+      }
+  }
+
+  SchedulerChore * m_chores[CHORES];
+  uint16_t m_slot;
+};
+
+#endif
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
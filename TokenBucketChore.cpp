@@ -0,0 +1,154 @@
+/*********************************************************************
+  TokenBucketChore.cpp - rate limited event chore.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "TokenBucketChore.h"
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * An event chore is created with a full bucket.
+ *
+ * @param[in] burst - most runs back to back, at least one
+ * @param[in] refill - time to gain one run, milli-seconds
+ */
+
+TokenBucketChore::
+TokenBucketChore (uint8_t burst, uint32_t refill)
+  : SchedulerChore (0),
+    m_refill ((refill == 0) ? 1 : refill),
+    m_refillTime (0),
+    m_burst ((burst == 0) ? 1 : burst),
+    m_tokens (m_burst)
+{
+}
+
+
+// ----------------------------------------------------------------------------
+/** Request a run.
+ *
+ * The chore is triggered to run now if a token is left, or when
+ * the next token is due.  Nothing is done if a run is already
+ * pending, that is if the chore is queued in its scheduler.  A
+ * run aborted with the chore is no longer pending.
+ *
+ * @retval 0 - run pending
+ * @retval -1 - chore not scheduled
+ */
+
+int TokenBucketChore::
+Request()
+{
+  if (IsQueued())
+    {
+      return (0);
+    }
+
+  Scheduler * sched = Parent();
+  if (sched == 0 || ! IsScheduled())
+    {
+      return (-1);
+    }
+
+  uint32_t now = sched->Now();
+  Refill (now);
+
+  return sched->Trigger (this, (m_tokens > 0) ? 0 : NextToken (now));
+}
+
+
+// ----------------------------------------------------------------------------
+/** Run chore.
+ *
+ * A token is taken and the chore is processed.  If the bucket is
+ * empty, which happens only when the chore was triggered
+ * directly, the run is put off until the next token.
+ */
+
+void TokenBucketChore::
+Run ()
+{
+  uint32_t now = Parent()->Now();
+  Refill (now);
+
+  if (m_tokens == 0)
+    {
+      Parent()->Trigger (this, NextToken (now));
+      return;
+    }
+
+  --m_tokens;
+  Process();
+}
+
+
+// ------------------------------------------------------------------
+/** Add tokens earned since the last refill.
+ *
+ * A full bucket does not save up time, so a burst after a quiet
+ * spell is followed by the steady rate.
+ */
+
+void TokenBucketChore::
+Refill (uint32_t now)
+{
+  if (m_tokens >= m_burst)
+    {
+      m_refillTime = now;
+      return;
+    }
+
+  uint32_t earned = (now - m_refillTime) / m_refill;
+  if (earned == 0)
+    {
+      return;
+    }
+
+  if (earned >= (uint32_t) (m_burst - m_tokens))
+    {
+      m_tokens = m_burst;
+      m_refillTime = now;
+    }
+  else
+    {
+      m_tokens += earned;
+      m_refillTime += earned * m_refill;
+    }
+}
+
+
+// ------------------------------------------------------------------
+/** Get delay to trigger with for the next token.
+ *
+ * The scheduler runs chores up to a milli-second early, so one
+ * more is added.
+ */
+
+uint32_t TokenBucketChore::
+NextToken (uint32_t now) const
+{
+  uint32_t since = now - m_refillTime;
+  return (since < m_refill) ? m_refill - since + 1 : 0;
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,114 @@
+/*********************************************************************
+  TokenBucketChore.h - rate limited event chore.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (TokenBucketChore_H_)
+#define TokenBucketChore_H_
+
+#include <Scheduler.h>
+
+// ----------------------------------------------------------------------------
+/** Token bucket chore.
+ *
+ * This class is the base class for event chores that must run as
+ * soon as there is work, but not more than a set rate, such as a
+ * radio transmit or a log flush.  Each run takes a token from a
+ * bucket that holds up to a burst of tokens and gains one token
+ * each refill time.
+ *
+ * Request() is called when there is work.  If a token is left,
+ * the chore is triggered to run now, otherwise it is triggered to
+ * run when the next token is due, so there is no polling.  A
+ * chore that has more work can call Request() from Process() to
+ * run again.  Requests made while a run is pending are merged
+ * into that run.
+ *
+ * The chore has interval zero and is scheduled like any event
+ * chore.  Derived classes supply Process() in place of Run().
+ *
+ * Example:
+\code
+class flush_chore : public TokenBucketChore
+{
+public:
+  flush_chore() : TokenBucketChore (4, 250) { }  // 4 per second
+
+private:
+  virtual void Process()
+  {
+    write_some_log();
+    if (log_pending())
+      {
+        Request();
+      }
+  }
+};
+
+flush_chore  flusher;
+the_scheduler.Schedule (& flusher);
+
+// when a log record is added
+flusher.Request();
+\endcode
+ */
+
+class TokenBucketChore
+  : public SchedulerChore
+{
+public:
+  TokenBucketChore (uint8_t burst, uint32_t refill);
+
+  int Request();
+
+  /// Return tokens in the bucket when last counted.
+  uint8_t Tokens() const { return m_tokens; }
+
+  /// Return true if a run is pending.
+  bool IsPending() const { return IsQueued(); }
+
+
+protected:
+  /** Procedure to run.  This method is the do-it function for
+   * this chore, run once for each token.
+   */
+  virtual void Process () = 0;
+
+
+private:
+  virtual void Run ();
+
+  void Refill (uint32_t now);
+  uint32_t NextToken (uint32_t now) const;
+
+  /// Time for one token, milli-seconds.
+  uint32_t m_refill;
+
+  /// Time the last token was added, milli-seconds.
+  uint32_t m_refillTime;
+
+  uint8_t m_burst;
+  uint8_t m_tokens;
+};
+
+#endif	// TokenBucketChore_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
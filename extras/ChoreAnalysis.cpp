@@ -0,0 +1,125 @@
+/*********************************************************************
+  ChoreAnalysis.cpp - check that a chore set fits, from a table.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+//
+// Reads a table of chores, one per line as
+//
+//   id  interval-msec  worst-case-run-time-usec
+//
+// from a file or standard input, and prints the utilization,
+// hyperperiod, worst case response times with rate monotonic
+// order, the earliest deadline first test, and the worst case
+// lateness with the scheduler's own order.  Lines starting with #
+// are ignored.  Build from the library directory with
+//
+//   g++ -O2 -I extras/host -I . -o chore_analysis
+//       extras/ChoreAnalysis.cpp extras/host/ScheduleAnalysis.cpp
+//
+// (all on one line) and run ./chore_analysis [table].
+//
+
+#include "WProgram.h"
+#include "ScheduleAnalysis.h"
+
+#include <cstdio>
+
+
+int
+main (int argc, char * argv[])
+{
+  FILE * fp = (argc > 1) ? fopen (argv[1], "r") : stdin;
+  if (fp == 0)
+    {
+      perror (argv[1]);
+      return (1);
+    }
+
+  ScheduleAnalysis analysis;
+  char line[256];
+
+  while (fgets (line, sizeof (line), fp) != 0)
+    {
+      unsigned id, period, wcet;
+
+      if (line[0] == '#')
+        {
+          continue;
+        }
+
+      if (sscanf (line, "%u %u %u", & id, & period, & wcet) == 3)
+        {
+          analysis.Add (id, period, wcet);
+        }
+    }
+
+  analysis.Analyse();
+
+  printf ("utilization      %.1f %%\n", analysis.Utilization() * 100);
+  printf ("hyperperiod      %llu ms\n", (unsigned long long) analysis.Hyperperiod());
+  if (analysis.BusyPeriod() != ScheduleAnalysis::UNBOUNDED)
+    {
+      printf ("busy period      %llu us\n", (unsigned long long) analysis.BusyPeriod());
+    }
+  else
+    {
+      printf ("busy period      overloaded\n");
+    }
+
+  printf ("rate monotonic   %s\n", analysis.RmFeasible() ? "fits" : "misses deadlines");
+  printf ("edf              %s\n\n", analysis.EdfFeasible() ? "fits" : "misses deadlines");
+
+  printf ("   id  interval ms    wcet us  rm response us  lateness us\n");
+
+  const std::vector< ChoreTiming > & chores = analysis.Chores();
+  for (size_t i = 0; i < chores.size(); ++i)
+    {
+      const ChoreTiming & ct = chores[i];
+      char rm[24];
+      char late[24];
+
+      if (ct.m_rmResponse != ScheduleAnalysis::UNBOUNDED)
+        {
+          snprintf (rm, sizeof (rm), "%llu", (unsigned long long) ct.m_rmResponse);
+        }
+      else
+        {
+          snprintf (rm, sizeof (rm), "miss");
+        }
+
+      if (ct.m_lateness != ScheduleAnalysis::UNBOUNDED)
+        {
+          snprintf (late, sizeof (late), "%llu", (unsigned long long) ct.m_lateness);
+        }
+      else
+        {
+          snprintf (late, sizeof (late), "overloaded");
+        }
+
+      printf ("%5u %12u %10u %15s %12s\n", ct.m_id, ct.m_period, ct.m_wcet,
+              rm, late);
+    }
+
+  return (analysis.RmFeasible() && analysis.EdfFeasible()) ? 0 : 2;
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,422 @@
+/*********************************************************************
+  CalendarQueue.cpp - calendar queue policy for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "CalendarQueue.h"
+
+
+namespace {
+
+// fewest buckets the queue shrinks to
+const uint32_t MIN_BUCKETS = 16;
+
+// widest bucket, as log2 of milli-seconds
+const uint8_t MAX_SHIFT = 24;
+
+} // end namespace
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * An empty queue is created.
+ *
+ * @param[in] buckets - initial number of buckets, power of two
+ * @param[in] width_shift - initial bucket width as log2 of milli-seconds
+ */
+
+CalendarQueue::
+CalendarQueue (uint32_t buckets, uint8_t width_shift)
+  : m_buckets (0),
+    m_count (0),
+    m_shift (width_shift),
+    m_size (0),
+    m_current (0),
+    m_bucketStart (0),
+    m_head (0),
+    m_spacing (0),
+    m_lastHeadTime (0),
+    m_headCount (0)
+{
+  // round up to a power of two
+  m_count = MIN_BUCKETS;
+  while (m_count < buckets)
+    {
+      m_count <<= 1;
+    }
+
+  m_buckets = new SchedulerChore * [m_count];
+  for (uint32_t i = 0; i < m_count; ++i)
+    {
+      m_buckets[i] = 0;
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Destructor.
+ *
+ */
+
+CalendarQueue::
+~CalendarQueue()
+{
+  delete [] m_buckets;
+}
+
+
+// ------------------------------------------------------------------
+/** Insert chore into calendar.
+ *
+ * The chore is added to the bucket for its expiration time.  The
+ * calendar grows when there are more than two chores per bucket.
+ */
+
+void CalendarQueue::
+Insert (SchedulerChore * chore)
+{
+  uint32_t t = TargetTime (chore);
+
+  if (m_size == 0 || int32_t (t - m_bucketStart) < 0)
+    {
+      // search for the head must start at this chore
+      m_current = BucketOf (t);
+      m_bucketStart = t & ~(BucketWidth() - 1);
+    }
+
+  if (m_size == 0 || (m_head != 0 && *chore < *m_head))
+    {
+      m_head = chore;
+    }
+
+  Link (chore);
+  ++m_size;
+
+  if (m_size > 2 * m_count)
+    {
+      Resize (2 * m_count, m_shift);
+    }
+}
+
+
+// ------------------------------------------------------------------
+/** Remove chore from calendar.
+ *
+ * When the head of the queue is removed, the spacing from the
+ * previous head is used to track the best bucket width.  The
+ * calendar shrinks when there are fewer chores than half the
+ * buckets.
+ */
+
+void CalendarQueue::
+Remove (SchedulerChore * chore)
+{
+  uint32_t t = TargetTime (chore);
+  uint32_t b = BucketOf (t);
+
+  if (Next (chore) == chore)
+    {
+      m_buckets[b] = 0;
+    }
+  else if (m_buckets[b] == chore)
+    {
+      m_buckets[b] = Next (chore);
+    }
+
+  Unlink (chore);
+  --m_size;
+
+  if (chore == m_head)
+    {
+      m_head = 0;
+
+      // running average of spacing, weight 1/8
+      int32_t gap (t - m_lastHeadTime);
+      if (m_headCount != 0 && gap >= 0)
+        {
+          m_spacing = m_spacing - (m_spacing >> 3) + ((uint32_t) gap << 1);
+        }
+
+      m_lastHeadTime = t;
+
+      // review the bucket width once per calendar year
+      if (++m_headCount % m_count == 0)
+        {
+          uint8_t ideal = IdealShift();
+          if (ideal > m_shift + 1 || ideal + 1 < m_shift)
+            {
+              Resize (m_count, ideal);
+              return;
+            }
+        }
+    }
+
+  if (m_count > MIN_BUCKETS && m_size < m_count / 2)
+    {
+      Resize (m_count / 2, m_shift);
+    }
+}
+
+
+// ------------------------------------------------------------------
+/** Get chore that expires first.
+ *
+ */
+
+SchedulerChore * CalendarQueue::
+Head ()
+{
+  if (m_head == 0 && m_size != 0)
+    {
+      m_head = FindHead();
+    }
+
+  return (m_head);
+}
+
+
+// ------------------------------------------------------------------
+/** Empty the calendar.
+ *
+ * Each chore is detached from its scheduler.
+ */
+
+void CalendarQueue::
+Clear ()
+{
+  for (uint32_t i = 0; i < m_count; ++i)
+    {
+      SchedulerChore * first = m_buckets[i];
+      if (first != 0)
+        {
+          SchedulerChore * ptr = first;
+          do
+            {
+              SchedulerChore * next = Next (ptr);
+              Detach (ptr);
+              ptr = next;
+            }
+          while (ptr != first);
+        }
+
+      m_buckets[i] = 0;
+    }
+
+  m_size = 0;
+  m_head = 0;
+}
+
+
+// ------------------------------------------------------------------
+/** Link chore into its bucket.
+ *
+ * Each bucket is a circular list sorted by expiration time.  The
+ * chore is linked after the chores that expire at the same time.
+ */
+
+void CalendarQueue::
+Link (SchedulerChore * chore)
+{
+  uint32_t b = BucketOf (TargetTime (chore));
+  SchedulerChore * first = m_buckets[b];
+
+  if (first == 0)
+    {
+      Next (chore) = chore;
+      Prev (chore) = chore;
+      m_buckets[b] = chore;
+      return;
+    }
+
+  // Most chores expire after all others in the bucket
+  if (! (*chore < *Prev (first)))
+    {
+      LinkBefore (chore, first);
+      return;
+    }
+
+  // Find the first chore that expires after the new one
+  SchedulerChore * ptr = first;
+  do
+    {
+      if (*chore < *ptr)
+        {
+          break;
+        }
+
+      ptr = Next (ptr);
+    }
+  while (ptr != first);
+
+  // insert in front of that chore, or at the end of the list
+  LinkBefore (chore, ptr);
+
+  if (*chore < *first)
+    {
+      m_buckets[b] = chore;
+    }
+}
+
+
+// ------------------------------------------------------------------
+/** Find chore that expires first.
+ *
+ * The buckets are searched for one calendar year from the current
+ * bucket.  A chore in a bucket's time slot for this year is the
+ * head.  If there is none, all chores are far in the future and
+ * the earliest first chore of any bucket is used.
+ */
+
+SchedulerChore * CalendarQueue::
+FindHead ()
+{
+  uint32_t b = m_current;
+  uint32_t start = m_bucketStart;
+  uint32_t width = BucketWidth();
+
+  for (uint32_t i = 0; i < m_count; ++i)
+    {
+      SchedulerChore * first = m_buckets[b];
+      if (first != 0 && int32_t (TargetTime (first) - (start + width)) < 0)
+        {
+          m_current = b;
+          m_bucketStart = start;
+          return (first);
+        }
+
+      b = (b + 1) & (m_count - 1);
+      start += width;
+    } // end for
+
+  return (SearchAll());
+}
+
+
+// ------------------------------------------------------------------
+/** Find chore that expires first by looking at every bucket.
+ *
+ * The current bucket is moved to the bucket of that chore.
+ */
+
+SchedulerChore * CalendarQueue::
+SearchAll ()
+{
+  SchedulerChore * best = 0;
+
+  for (uint32_t i = 0; i < m_count; ++i)
+    {
+      SchedulerChore * first = m_buckets[i];
+      if (first != 0 && (best == 0 || *first < *best))
+        {
+          best = first;
+        }
+    } // end for
+
+  m_current = BucketOf (TargetTime (best));
+  m_bucketStart = TargetTime (best) & ~(BucketWidth() - 1);
+
+  return (best);
+}
+
+
+// ------------------------------------------------------------------
+/** Rebuild calendar.
+ *
+ * All chores are moved to a new set of buckets.
+ *
+ * @param[in] buckets - new number of buckets, power of two
+ * @param[in] width_shift - new bucket width as log2 of milli-seconds
+ */
+
+void CalendarQueue::
+Resize (uint32_t buckets, uint8_t width_shift)
+{
+  SchedulerChore ** old = m_buckets;
+  uint32_t old_count = m_count;
+
+  m_buckets = new SchedulerChore * [buckets];
+  m_count = buckets;
+  m_shift = width_shift;
+
+  for (uint32_t i = 0; i < m_count; ++i)
+    {
+      m_buckets[i] = 0;
+    }
+
+  for (uint32_t i = 0; i < old_count; ++i)
+    {
+      SchedulerChore * first = old[i];
+      if (first == 0)
+        {
+          continue;
+        }
+
+      SchedulerChore * ptr = first;
+      do
+        {
+          SchedulerChore * next = Next (ptr);
+          Link (ptr);
+          ptr = next;
+        }
+      while (ptr != first);
+    } // end for
+
+  delete [] old;
+
+  m_head = 0;
+  if (m_size != 0)
+    {
+      m_head = SearchAll();
+    }
+}
+
+
+// ------------------------------------------------------------------
+/** Get best bucket width.
+ *
+ * The best width is about three times the average spacing of
+ * expiration times, which puts a few chores in each bucket.
+ *
+ * @return bucket width as log2 of milli-seconds
+ */
+
+uint8_t CalendarQueue::
+IdealShift () const
+{
+  if (m_headCount < m_count)
+    {
+      return (m_shift);
+    }
+
+  // spacing is in 1/16 msec
+  uint32_t width = (3 * m_spacing) >> 4;
+  uint8_t shift = 0;
+
+  while (((uint32_t) 1 << shift) < width && shift < MAX_SHIFT)
+    {
+      ++shift;
+    }
+
+  return (shift);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,115 @@
+/*********************************************************************
+  CalendarQueue.h - calendar queue policy for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (CalendarQueue_H_)
+#define CalendarQueue_H_
+
+#include <Scheduler.h>
+
+// ----------------------------------------------------------------------------
+/** Calendar queue.
+ *
+ * This scheduler queue is meant for hosts that run thousands of
+ * chores.  Time is divided into buckets of equal width, like the
+ * days of a calendar year, and each chore is kept in the bucket
+ * for its expiration time.  When the bucket width is close to the
+ * spacing between expiration times, each bucket holds only a few
+ * chores, so inserting a chore and finding the next one take
+ * constant time on average.
+ *
+ * The queue resizes itself: the number of buckets doubles or
+ * halves with the number of chores, and the bucket width follows
+ * the observed spacing between the chores taken from the head of
+ * the queue.  Bucket count and width are powers of two, so the
+ * bucket of a time is found with a shift and a mask and the
+ * calendar stays consistent when the clock wraps.
+ *
+ * The buckets are allocated from the heap, so this queue is not
+ * intended for small boards.
+ *
+ * Example:
+\code
+CalendarQueue  the_queue;
+
+the_scheduler.Queue (& the_queue);
+\endcode
+ */
+
+class CalendarQueue : public SchedulerQueue
+{
+public:
+  CalendarQueue (uint32_t buckets = 16, uint8_t width_shift = 4);
+  virtual ~CalendarQueue();
+
+  virtual void Insert (SchedulerChore * chore);
+  virtual void Remove (SchedulerChore * chore);
+  virtual SchedulerChore * Head ();
+  virtual void Clear ();
+
+  /// Return number of chores in the queue.
+  uint32_t Size() const { return m_size; }
+
+  /// Return number of buckets.
+  uint32_t BucketCount() const { return m_count; }
+
+  /// Return width of a bucket, milli-seconds.
+  uint32_t BucketWidth() const { return (uint32_t) 1 << m_shift; }
+
+
+private:
+  uint32_t BucketOf (uint32_t t) const { return (t >> m_shift) & (m_count - 1); }
+
+  void Link (SchedulerChore * chore);
+  void Resize (uint32_t buckets, uint8_t width_shift);
+  SchedulerChore * FindHead ();
+  SchedulerChore * SearchAll ();
+  uint8_t IdealShift () const;
+
+  /// First chore of each bucket, in circular lists.
+  SchedulerChore ** m_buckets;
+
+  uint32_t m_count;             // number of buckets
+  uint8_t m_shift;              // log2 of bucket width
+  uint32_t m_size;              // number of chores
+
+  /// Bucket where the search for the head starts, and the start
+  /// time of that bucket in the current year.
+  uint32_t m_current;
+  uint32_t m_bucketStart;
+
+  /// Head of queue, or 0 if it must be searched for.
+  SchedulerChore * m_head;
+
+  /// Average spacing of chores taken from the head, 1/16 msec.
+  uint32_t m_spacing;
+  uint32_t m_lastHeadTime;
+  uint32_t m_headCount;
+
+  // NON_COPYABLE
+  CalendarQueue (const CalendarQueue &);
+  const CalendarQueue & operator= (const CalendarQueue &);
+};
+
+#endif	// CalendarQueue_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,327 @@
+/*********************************************************************
+  ExpiredScan.cpp - find expired chores in a time array.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "ExpiredScan.h"
+
+#if defined (SCAN_X86)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+// ----------------------------------------------------------------------------
+/** Scan part of the time array, one time at a time.
+ *
+ * The loop has no branches on the data, so the compiler can
+ * vectorize it where the target allows.
+ *
+ * @param[in] targets - expiration times
+ * @param[in] begin - first index to scan
+ * @param[in] count - number of times
+ * @param[in] now - current time
+ * @param[in,out] expired - indexes of expired times
+ * @param[in,out] found - number of expired times
+ * @param[in,out] least - smallest time to expiration of the
+ * times not expired
+ */
+
+inline void
+ScanRange (const uint32_t * targets, uint32_t begin, uint32_t count,
+           uint32_t now, uint32_t * expired, uint32_t & found,
+           int32_t & least)
+{
+  for (uint32_t i = begin; i < count; ++i)
+    {
+      int32_t delta = (int32_t) (targets[i] - now);
+
+      int32_t wait = (delta <= 1) ? INT32_MAX : delta;
+
+      expired[found] = i;
+      found += (delta <= 1);
+      least = (wait < least) ? wait : least;
+    }
+}
+
+} // end namespace
+
+
+// ----------------------------------------------------------------------------
+/** Find expired times, one at a time.
+ *
+ * @param[in] targets - expiration times
+ * @param[in] count - number of times
+ * @param[in] now - current time
+ * @param[out] expired - indexes of expired times
+ * @param[out] next - smallest time to expiration of the times
+ * not expired, msec, signed
+ * @return number of expired times.
+ */
+
+uint32_t
+ScanExpiredScalar (const uint32_t * targets, uint32_t count, uint32_t now,
+                   uint32_t * expired, int32_t & next)
+{
+  uint32_t found = 0;
+  int32_t least = INT32_MAX;
+
+  ScanRange (targets, 0, count, now, expired, found, least);
+
+  next = least;
+  return (found);
+}
+
+
+#if defined (SCAN_X86)
+
+namespace {
+
+// ----------------------------------------------------------------------------
+/** Table of set bit positions.
+ *
+ * Entry m holds the positions of the bits set in m, one per
+ * byte, lowest first, and the number of bits set, so the expired
+ * lanes of a vector compare are found with one lookup.
+ */
+
+struct LaneTable
+{
+  LaneTable()
+  {
+    for (uint32_t m = 0; m < 256; ++m)
+      {
+        uint64_t lanes = 0;
+        uint8_t n = 0;
+
+        for (uint8_t bit = 0; bit < 8; ++bit)
+          {
+            if (m & (1 << bit))
+              {
+                lanes |= (uint64_t) bit << (8 * n++);
+              }
+          }
+        m_lanes[m] = lanes;
+        m_count[m] = n;
+      }
+  }
+
+  uint64_t m_lanes[256];
+  uint8_t m_count[256];
+};
+
+const LaneTable s_lanes;
+
+} // end namespace
+
+
+// ----------------------------------------------------------------------------
+/** Find expired times, four at a time.
+ *
+ * The differences are compared four lanes at a time, and the
+ * indexes of the expired lanes are looked up from the compare
+ * mask.  Expired lanes are left out of the minimum.  SSE2 has no
+ * signed 32 bit minimum, so it is done with a compare and select.
+ *
+ * @param[in] targets - expiration times
+ * @param[in] count - number of times
+ * @param[in] now - current time
+ * @param[out] expired - indexes of expired times
+ * @param[out] next - smallest time to expiration of the times
+ * not expired, msec, signed
+ * @return number of expired times.
+ */
+
+__attribute__ ((target ("sse2")))
+uint32_t
+ScanExpiredSse2 (const uint32_t * targets, uint32_t count, uint32_t now,
+                 uint32_t * expired, int32_t & next)
+{
+  const __m128i vnow = _mm_set1_epi32 (now);
+  const __m128i limit = _mm_set1_epi32 (2);
+  const __m128i vmax = _mm_set1_epi32 (INT32_MAX);
+  __m128i vleast = vmax;
+  uint32_t found = 0;
+  uint32_t i = 0;
+
+  for ( ; i + 4 <= count; i += 4)
+    {
+      __m128i delta = _mm_sub_epi32 (_mm_loadu_si128 ((const __m128i *) (targets + i)),
+                                     vnow);
+
+      // expired when delta < 2
+      __m128i exp = _mm_cmplt_epi32 (delta, limit);
+      __m128i wait = _mm_or_si128 (_mm_and_si128 (exp, vmax),
+                                   _mm_andnot_si128 (exp, delta));
+
+      __m128i lt = _mm_cmplt_epi32 (wait, vleast);
+      vleast = _mm_or_si128 (_mm_and_si128 (lt, wait),
+                             _mm_andnot_si128 (lt, vleast));
+
+      int mask = _mm_movemask_ps (_mm_castsi128_ps (exp));
+      if (mask != 0)
+        {
+          // store four indexes, keep the expired ones
+          __m128i lanes = _mm_cvtsi32_si128 ((int) s_lanes.m_lanes[mask]);
+          lanes = _mm_unpacklo_epi8 (lanes, _mm_setzero_si128());
+          lanes = _mm_unpacklo_epi16 (lanes, _mm_setzero_si128());
+          _mm_storeu_si128 ((__m128i *) (expired + found),
+                            _mm_add_epi32 (lanes, _mm_set1_epi32 (i)));
+          found += s_lanes.m_count[mask];
+        }
+    }
+
+  int32_t part[4];
+  _mm_storeu_si128 ((__m128i *) part, vleast);
+
+  int32_t least = INT32_MAX;
+  for (int k = 0; k < 4; ++k)
+    {
+      least = (part[k] < least) ? part[k] : least;
+    }
+
+  ScanRange (targets, i, count, now, expired, found, least);
+
+  next = least;
+  return (found);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Find expired times, eight at a time.
+ *
+ * As the SSE2 kernel, with eight lanes and a true minimum.  This
+ * function is compiled for AVX2 whatever the compiler options,
+ * and must only be called when the processor supports it.
+ *
+ * @param[in] targets - expiration times
+ * @param[in] count - number of times
+ * @param[in] now - current time
+ * @param[out] expired - indexes of expired times
+ * @param[out] next - smallest time to expiration of the times
+ * not expired, msec, signed
+ * @return number of expired times.
+ */
+
+__attribute__ ((target ("avx2")))
+uint32_t
+ScanExpiredAvx2 (const uint32_t * targets, uint32_t count, uint32_t now,
+                 uint32_t * expired, int32_t & next)
+{
+  const __m256i vnow = _mm256_set1_epi32 (now);
+  const __m256i limit = _mm256_set1_epi32 (2);
+  const __m256i vmax = _mm256_set1_epi32 (INT32_MAX);
+  __m256i vleast = vmax;
+  uint32_t found = 0;
+  uint32_t i = 0;
+
+  for ( ; i + 8 <= count; i += 8)
+    {
+      __m256i delta = _mm256_sub_epi32 (_mm256_loadu_si256 ((const __m256i *) (targets + i)),
+                                        vnow);
+
+      // expired when delta < 2
+      __m256i exp = _mm256_cmpgt_epi32 (limit, delta);
+
+      vleast = _mm256_min_epi32 (vleast, _mm256_blendv_epi8 (delta, vmax, exp));
+
+      int mask = _mm256_movemask_ps (_mm256_castsi256_ps (exp));
+      if (mask != 0)
+        {
+          // store eight indexes, keep the expired ones
+          __m256i lanes = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) & s_lanes.m_lanes[mask]));
+          _mm256_storeu_si256 ((__m256i *) (expired + found),
+                               _mm256_add_epi32 (lanes, _mm256_set1_epi32 (i)));
+          found += s_lanes.m_count[mask];
+        }
+    }
+
+  // reduce eight lanes to one
+  __m128i half = _mm_min_epi32 (_mm256_castsi256_si128 (vleast),
+                                _mm256_extracti128_si256 (vleast, 1));
+  half = _mm_min_epi32 (half, _mm_shuffle_epi32 (half, _MM_SHUFFLE (1, 0, 3, 2)));
+  half = _mm_min_epi32 (half, _mm_shuffle_epi32 (half, _MM_SHUFFLE (2, 3, 0, 1)));
+
+  int32_t least = _mm_cvtsi128_si32 (half);
+
+  ScanRange (targets, i, count, now, expired, found, least);
+
+  next = least;
+  return (found);
+}
+
+#endif // SCAN_X86
+
+
+// ----------------------------------------------------------------------------
+/** Return the fastest kernel.
+ *
+ * @return kernel to use on this processor.
+ */
+
+ScanKernel
+BestScanKernel ()
+{
+#if defined (SCAN_X86)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      return (ScanExpiredAvx2);
+    }
+
+  if (__builtin_cpu_supports ("sse2"))
+    {
+      return (ScanExpiredSse2);
+    }
+#endif
+
+  return (ScanExpiredScalar);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Return name of a kernel.
+ *
+ * @param[in] kernel - kernel
+ * @return name of the kernel.
+ */
+
+const char *
+ScanKernelName (ScanKernel kernel)
+{
+#if defined (SCAN_X86)
+  if (kernel == ScanExpiredAvx2)
+    {
+      return ("avx2");
+    }
+
+  if (kernel == ScanExpiredSse2)
+    {
+      return ("sse2");
+    }
+#endif
+
+  return ("scalar");
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,69 @@
+/*********************************************************************
+  ExpiredScan.h - find expired chores in a time array.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (ExpiredScan_H_)
+#define ExpiredScan_H_
+
+#include <inttypes.h>
+
+//
+// Kernels that scan an array of expiration times for the expired
+// ones, for the FlatScheduler.  A time is expired when it is no
+// more than 1 msec after now, compared as a signed difference so
+// the clock may wrap.  Each kernel returns the indexes of the
+// expired times in increasing order, and the smallest signed
+// difference between a time that is not expired and now, in one
+// pass.  The difference is INT32_MAX when all times are expired.
+//
+// The index array must have room for count + SCAN_SLACK entries,
+// since the vector kernels store whole vectors.
+//
+
+enum { SCAN_SLACK = 8 };
+
+/// Scan kernel.
+typedef uint32_t (* ScanKernel) (const uint32_t * targets, uint32_t count,
+                                 uint32_t now, uint32_t * expired,
+                                 int32_t & next);
+
+uint32_t ScanExpiredScalar (const uint32_t * targets, uint32_t count,
+                            uint32_t now, uint32_t * expired, int32_t & next);
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define SCAN_X86
+
+uint32_t ScanExpiredSse2 (const uint32_t * targets, uint32_t count,
+                          uint32_t now, uint32_t * expired, int32_t & next);
+uint32_t ScanExpiredAvx2 (const uint32_t * targets, uint32_t count,
+                          uint32_t now, uint32_t * expired, int32_t & next);
+#endif
+
+/// Return the fastest kernel this processor supports.
+ScanKernel BestScanKernel ();
+
+/// Return name of a kernel.
+const char * ScanKernelName (ScanKernel kernel);
+
+#endif	// ExpiredScan_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,271 @@
+/*********************************************************************
+  FlatScheduler.cpp - array based scheduler for hosts.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "FlatScheduler.h"
+
+#include "WProgram.h"
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * An empty scheduler is created.
+ */
+
+FlatScheduler::
+FlatScheduler()
+  : m_baseTime (Scheduler::Millis()),
+    m_nextTime (0),
+    m_aborted (0),
+    m_dispatching (false),
+    m_scan (BestScanKernel())
+{ }
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * An empty scheduler is created, that runs as a chore with the
+ * specified interval.
+ *
+ * @param[in] inter - interval, milli-seconds
+ */
+
+FlatScheduler::
+FlatScheduler (uint32_t inter)
+  : SchedulerChore (inter),
+    m_baseTime (Scheduler::Millis()),
+    m_nextTime (0),
+    m_aborted (0),
+    m_dispatching (false),
+    m_scan (BestScanKernel())
+{ }
+
+
+// ----------------------------------------------------------------------------
+/** Run scheduler.
+ *
+ * All chores that have expired are run and rescheduled.
+ */
+
+void FlatScheduler::
+RunScheduler ()
+{
+  uint32_t now = GetCurrentTime();
+
+  // nothing expires before the time found by the last scan
+  if ((int32_t) (m_nextTime - now) > 1)
+    {
+      return;
+    }
+
+  m_expired.resize (m_targets.size() + SCAN_SLACK);
+
+  int32_t next;
+  uint32_t found = m_scan (m_targets.data(), m_targets.size(), now,
+                           m_expired.data(), next);
+  m_nextTime = now + next;
+
+  m_dispatching = true;
+  for (uint32_t i = 0; i < found; ++i)
+    {
+      uint32_t idx = m_expired[i];
+      SchedulerChore * chore = m_chores[idx];
+      if (chore == 0)
+        {
+          m_targets[idx] = now + 0x7fffffff; // aborted, push away
+          continue;
+        }
+
+      RunChore (chore);
+
+      // the chore may change its interval or be aborted
+      if (m_chores[idx] == chore)
+        {
+          m_intervals[idx] = chore->Interval();
+          m_targets[idx] += m_intervals[idx];
+
+          if ((int32_t) (m_targets[idx] - m_nextTime) < 0)
+            {
+              m_nextTime = m_targets[idx];
+            }
+        }
+    }
+  m_dispatching = false;
+
+  if (m_aborted > m_chores.size() / 2)
+    {
+      Compact();
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Schedule a chore.
+ *
+ * The chore first expires one interval from now.
+ *
+ * @param[in] chore - chore to schedule
+ * @retval 0 - chore scheduled
+ * @retval -1 - chore is an event chore, or already scheduled
+ */
+
+int FlatScheduler::
+Schedule (SchedulerChore * chore)
+{
+  if (chore->Interval() == 0
+      || ! m_index.insert (std::make_pair (chore, m_chores.size())).second)
+    {
+      return (-1);
+    }
+
+  uint32_t target = GetCurrentTime() + chore->Interval();
+
+  m_targets.push_back (target);
+  m_intervals.push_back (chore->Interval());
+  m_chores.push_back (chore);
+
+  if ((int32_t) (target - m_nextTime) < 0)
+    {
+      m_nextTime = target;
+    }
+
+  return (0);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Abort a chore.
+ *
+ * The chore is marked and removed later, so chores can be aborted
+ * while chores are running.
+ *
+ * @param[in] chore - chore to abort
+ * @retval 0 - chore aborted
+ * @retval -1 - chore not scheduled here
+ */
+
+int FlatScheduler::
+AbortChore (SchedulerChore * chore)
+{
+  std::unordered_map< SchedulerChore *, uint32_t >::iterator it = m_index.find (chore);
+  if (it == m_index.end())
+    {
+      return (-1);
+    }
+
+  Abort (it->second);
+  m_index.erase (it);
+  return (0);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Abort all chores.
+ *
+ */
+
+void FlatScheduler::
+AbortAllChores ()
+{
+  m_index.clear();
+
+  if (m_dispatching)
+    {
+      for (uint32_t i = 0; i < m_chores.size(); ++i)
+        {
+          if (m_chores[i] != 0)
+            {
+              Abort (i);
+            }
+        }
+      return;
+    }
+
+  m_targets.clear();
+  m_intervals.clear();
+  m_chores.clear();
+  m_aborted = 0;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Mark a chore aborted.
+ *
+ * The entry is kept so the indexes of the current pass stay
+ * valid, and is removed by Compact().
+ *
+ * @param[in] idx - index of the chore
+ */
+
+void FlatScheduler::
+Abort (uint32_t idx)
+{
+  m_chores[idx] = 0;
+  m_targets[idx] = GetCurrentTime() + 0x7fffffff; // never expires
+  ++m_aborted;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Remove aborted chores from the arrays.
+ *
+ */
+
+void FlatScheduler::
+Compact ()
+{
+  uint32_t out = 0;
+
+  for (uint32_t i = 0; i < m_chores.size(); ++i)
+    {
+      if (m_chores[i] != 0)
+        {
+          m_targets[out] = m_targets[i];
+          m_intervals[out] = m_intervals[i];
+          m_chores[out] = m_chores[i];
+          m_index[m_chores[out]] = out;
+          ++out;
+        }
+    }
+
+  m_targets.resize (out);
+  m_intervals.resize (out);
+  m_chores.resize (out);
+  m_aborted = 0;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Get current scheduler time.
+ *
+ * @return current time, milli-seconds
+ */
+
+uint32_t FlatScheduler::
+GetCurrentTime() const
+{
+  return (Scheduler::Millis() - m_baseTime);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,124 @@
+/*********************************************************************
+  FlatScheduler.h - array based scheduler for hosts.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (FlatScheduler_H_)
+#define FlatScheduler_H_
+
+#include <Scheduler.h>
+#include "ExpiredScan.h"
+
+#include <unordered_map>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+/** Flat array scheduler.
+ *
+ * This scheduler is meant for hosts that run tens of thousands of
+ * chores.  The expiration times of all chores are kept in one
+ * contiguous array, and the intervals and chore pointers in
+ * separate arrays with the same index.  Finding the expired chores
+ * is a scan of the time array, which touches four bytes per chore
+ * instead of a whole chore object per chore, and the chore objects
+ * are only touched when they run.
+ *
+ * Each pass scans the time array once, collecting the indexes of
+ * the expired chores and the time of the next expiration of the
+ * others.  The next time is lowered to that of each chore that is
+ * rescheduled.  Passes before that time return without scanning.  The scan uses the
+ * widest vector kernel the processor supports (see ExpiredScan.h).
+ *
+ * Chores expiring in the same pass run in the order they were
+ * scheduled, not in the order of their expiration times.  The
+ * chores are not attached to this scheduler, so they can not be
+ * triggered or aborted through the chore; use AbortChore() here.
+ * A chore is found from a hash of its address, so it can only be
+ * scheduled once.  Event chores and fractional periods are not
+ * supported.
+ *
+ * This scheduler is a chore, so it can run under a Scheduler.
+ *
+ * Example:
+\code
+FlatScheduler  the_scheduler;
+
+the_scheduler.Schedule (& chore);
+for (;;)
+  {
+    the_scheduler.RunScheduler();
+  }
+\endcode
+ */
+
+class FlatScheduler
+  : public SchedulerChore
+{
+public:
+  FlatScheduler ();
+  FlatScheduler (uint32_t inter);
+  virtual ~FlatScheduler() { }
+
+  void RunScheduler ();
+  int Schedule (SchedulerChore * chore);
+  int AbortChore (SchedulerChore * chore);
+  void AbortAllChores ();
+
+  /// Return number of chores scheduled.
+  uint32_t Size() const { return m_chores.size() - m_aborted; }
+
+  /// Return kernel used to find expired chores.
+  ScanKernel Kernel() const { return m_scan; }
+
+  /// Set kernel used to find expired chores.
+  void Kernel (ScanKernel kernel) { m_scan = kernel; }
+
+
+private:
+  virtual void Run() { RunScheduler(); }
+
+  uint32_t GetCurrentTime() const;
+  void Abort (uint32_t idx);
+  void Compact ();
+
+  /// Expiration time of each chore.
+  std::vector< uint32_t > m_targets;
+
+  /// Interval and chore, same index as the time.
+  std::vector< uint32_t > m_intervals;
+  std::vector< SchedulerChore * > m_chores;
+
+  /// Index of each scheduled chore.
+  std::unordered_map< SchedulerChore *, uint32_t > m_index;
+
+  /// Indexes of the chores expired in the current pass.
+  std::vector< uint32_t > m_expired;
+
+  uint32_t m_baseTime;
+  uint32_t m_nextTime;          // earliest expiration, from the last scan
+  uint32_t m_aborted;           // chores aborted but not yet removed
+  bool m_dispatching;
+  ScanKernel m_scan;
+};
+
+#endif	// FlatScheduler_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
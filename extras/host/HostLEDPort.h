@@ -0,0 +1,81 @@
+/*********************************************************************
+  HostLEDPort.h - simulated LED ports for host builds.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (HostLEDPort_H_)
+#define HostLEDPort_H_
+
+#include <MultiLEDflasher.h>
+
+// ----------------------------------------------------------------------------
+/** Simulated LED ports.
+ *
+ * This LED port backend keeps the output register of each port in
+ * memory and counts the port writes, so a MultiLEDflasher can be
+ * run and checked on a host.
+ *
+ * Example:
+\code
+HostLEDPort  ports;
+MultiLEDflasher  status (500, & ports);
+\endcode
+ */
+
+class HostLEDPort
+  : public LEDPort
+{
+public:
+  enum { PORTS = 16 };
+
+  HostLEDPort()
+    : m_writes (0)
+  {
+    for (uint8_t i = 0; i < PORTS; ++i)
+      {
+        m_out[i] = 0;
+      }
+  }
+
+  virtual void Write (uint8_t port, uint8_t mask, uint8_t level)
+  {
+    if (port < PORTS)
+      {
+        m_out[port] = (m_out[port] & ~mask) | (level & mask);
+      }
+    ++m_writes;
+  }
+
+  /// Return output register of a port.
+  uint8_t Output (uint8_t port) const { return m_out[port]; }
+
+  /// Return number of port writes.
+  uint32_t Writes() const { return m_writes; }
+
+
+private:
+  uint8_t m_out[PORTS];
+  uint32_t m_writes;
+};
+
+#endif
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
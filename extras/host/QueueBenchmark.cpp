@@ -0,0 +1,271 @@
+/*********************************************************************
+  QueueBenchmark.cpp - compare scheduler queue policies on a host.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+//
+// Runs a population of chores through a scheduler with each queue
+// policy for a few seconds of simulated time and reports the real
+// time spent per dispatch.  Build from the library directory with
+//
+//   g++ -O2 -DSCHEDULER_INTERVAL_QUEUE -I extras/host -I . -o queue_benchmark
+//       extras/host/*.cpp Scheduler.cpp SchedulerTrace.cpp
+//       SchedulerHistogram.cpp IntervalBucketQueue.cpp
+//
+// (all on one line) and run
+//
+//   ./queue_benchmark [simulated-seconds [policy [chores]]]
+//
+// A policy name, such as "flat avx2", runs only that policy, so
+// its cache behaviour can be measured on its own with
+//
+//   perf stat -e cache-references,cache-misses
+//       ./queue_benchmark 10 "flat avx2" 100000
+//
+
+#include "WProgram.h"
+#include "Scheduler.h"
+#include "CalendarQueue.h"
+#include "FlatScheduler.h"
+#include "IntervalBucketQueue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+namespace {
+
+// ----------------------------------------------------------------------------
+/** Benchmark chore.
+ *
+ * Counts its dispatches and does no other work, so the time
+ * measured is the scheduler's.
+ */
+
+class CountingChore : public SchedulerChore
+{
+public:
+  CountingChore (uint32_t inter)
+    : SchedulerChore (inter),
+      m_runs (0)
+  { }
+
+  static uint64_t s_runs;
+
+private:
+  virtual void Run()
+  {
+    ++m_runs;
+    ++s_runs;
+  }
+
+  uint32_t m_runs;
+};
+
+uint64_t CountingChore::s_runs = 0;
+
+
+// ----------------------------------------------------------------------------
+/** Chore population.
+ *
+ */
+
+enum Population
+  {
+    RANDOM_PERIODS,     // periods spread from 10 to 1000 msec
+    FEW_PERIODS         // periods of 10, 100 and 1000 msec
+  };
+
+const char * const s_populationNames[] = { "random periods", "few periods" };
+
+// policy to run, or 0 for all
+const char * s_policy = 0;
+
+
+// ----------------------------------------------------------------------------
+/** Run one benchmark case.
+ *
+ * @param[in] sched - scheduler to run, empty
+ * @param[in] name - name of the queue policy
+ * @param[in] chores - number of chores
+ * @param[in] pop - how periods are chosen
+ * @param[in] seconds - simulated time to run
+ */
+
+template < class S >
+void
+RunCase (S & sched, const char * name, uint32_t chores,
+         Population pop, uint32_t seconds)
+{
+  static const uint32_t few[] = { 10, 100, 1000 };
+
+  if (s_policy != 0 && strcmp (s_policy, name) != 0)
+    {
+      return;
+    }
+
+  srand (1);
+
+  std::vector< CountingChore * > list;
+  for (uint32_t i = 0; i < chores; ++i)
+    {
+      uint32_t inter = (pop == FEW_PERIODS)
+        ? few[i % 3]
+        : 10 + rand() % 991;
+
+      list.push_back (new CountingChore (inter));
+    }
+
+  // spread the phases over the first second
+  uint32_t next = 0;
+  for (uint32_t ms = 0; ms < 1000; ++ms)
+    {
+      for ( ; next < chores && next * 1000 / chores <= ms; ++next)
+        {
+          sched.Schedule (list[next]);
+        }
+
+      HostClock::Advance (1000);
+      sched.RunScheduler();
+    }
+
+  CountingChore::s_runs = 0;
+
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+  for (uint32_t ms = 0; ms < seconds * 1000; ++ms)
+    {
+      HostClock::Advance (1000);
+      sched.RunScheduler();
+    }
+
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration< double, std::nano > (end - begin).count();
+
+  printf ("%-16s %-15s %7u chores %10llu dispatches %8.1f ns/dispatch\n",
+          name, s_populationNames[pop], chores,
+          (unsigned long long) CountingChore::s_runs,
+          ns / (CountingChore::s_runs ? CountingChore::s_runs : 1));
+
+  sched.AbortAllChores();
+  for (uint32_t i = 0; i < chores; ++i)
+    {
+      delete list[i];
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Run one benchmark case with a Scheduler.
+ *
+ * @param[in] queue - queue policy to use, 0 for the default
+ * @param[in] name - name of the queue policy
+ * @param[in] chores - number of chores
+ * @param[in] pop - how periods are chosen
+ * @param[in] seconds - simulated time to run
+ */
+
+void
+RunQueueCase (SchedulerQueue * queue, const char * name, uint32_t chores,
+              Population pop, uint32_t seconds)
+{
+  HostClock::Set (0);
+
+  Scheduler sched;
+  sched.Queue (queue);
+
+  RunCase (sched, name, chores, pop, seconds);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Run one benchmark case with a FlatScheduler.
+ *
+ * @param[in] kernel - scan kernel to use
+ * @param[in] chores - number of chores
+ * @param[in] pop - how periods are chosen
+ * @param[in] seconds - simulated time to run
+ */
+
+void
+RunFlatCase (ScanKernel kernel, uint32_t chores, Population pop,
+             uint32_t seconds)
+{
+  HostClock::Set (0);
+
+  FlatScheduler sched;
+  sched.Kernel (kernel);
+
+  char name[32];
+  snprintf (name, sizeof (name), "flat %s", ScanKernelName (kernel));
+
+  RunCase (sched, name, chores, pop, seconds);
+}
+
+} // end namespace
+
+
+int
+main (int argc, char * argv[])
+{
+  uint32_t seconds = (argc > 1) ? atoi (argv[1]) : 2;
+  static uint32_t sizes[] = { 100, 1000, 10000 };
+  unsigned size_count = sizeof (sizes) / sizeof (sizes[0]);
+
+  if (argc > 2)
+    {
+      s_policy = argv[2];
+    }
+
+  if (argc > 3)
+    {
+      sizes[0] = atoi (argv[3]);
+      size_count = 1;
+    }
+
+  for (int p = RANDOM_PERIODS; p <= FEW_PERIODS; ++p)
+    {
+      for (unsigned s = 0; s < size_count; ++s)
+        {
+          RunQueueCase (0, "sorted list", sizes[s], Population (p), seconds);
+
+          CalendarQueue calendar;
+          RunQueueCase (& calendar, "calendar", sizes[s], Population (p), seconds);
+
+          IntervalBucketQueue buckets;
+          RunQueueCase (& buckets, "interval bucket", sizes[s], Population (p), seconds);
+
+          RunFlatCase (ScanExpiredScalar, sizes[s], Population (p), seconds);
+
+          if (BestScanKernel() != ScanExpiredScalar)
+            {
+              RunFlatCase (BestScanKernel(), sizes[s], Population (p), seconds);
+            }
+        }
+    }
+
+  return (0);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
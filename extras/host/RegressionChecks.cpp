@@ -0,0 +1,225 @@
+/*********************************************************************
+  RegressionChecks.cpp - check fixed scheduler faults on a host.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+//
+// Replays faults that have been fixed, on the simulated clock,
+// and reports any that are back.  Build from the library
+// directory with
+//
+//   g++ -I extras/host -I . -o regression_checks
+//       extras/host/RegressionChecks.cpp extras/host/WProgram.cpp
+//       Scheduler.cpp TokenBucketChore.cpp ResumableChore.cpp
+//
+// (all on one line) and run ./regression_checks.  It prints each
+// failed check and exits with the number of failures.
+//
+
+#include "WProgram.h"
+#include "Scheduler.h"
+#include "TokenBucketChore.h"
+#include "ResumableChore.h"
+
+#include <cstdio>
+
+
+namespace {
+
+int s_failures = 0;
+
+
+// ----------------------------------------------------------------------------
+/** Record result of a check.
+ *
+ * @param[in] ok - true if the check passed
+ * @param[in] what - what was checked
+ */
+
+void Check (bool ok, const char * what)
+{
+  if (! ok)
+    {
+      printf ("FAIL: %s\n", what);
+      ++s_failures;
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Run a scheduler on the simulated clock.
+ *
+ * @param[in] sched - scheduler
+ * @param[in] msec - time to run, milli-seconds
+ */
+
+void RunFor (Scheduler & sched, uint32_t msec)
+{
+  for (uint32_t i = 0; i < msec; ++i)
+    {
+      HostClock::Advance (1000);
+      sched.RunScheduler();
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/** Token bucket chore that counts its runs.
+ */
+
+class CountingBucket
+  : public TokenBucketChore
+{
+public:
+  CountingBucket () : TokenBucketChore (1, 100), m_runs (0) { }
+
+  int m_runs;
+
+private:
+  virtual void Process () { ++m_runs; }
+};
+
+
+// ----------------------------------------------------------------------------
+/** A request made while a TokenBucketChore waits for a token must
+ * not stay pending after the chore is aborted, or requests made
+ * after it is scheduled again are dropped.
+ */
+
+void CheckTokenBucketAbort ()
+{
+  Scheduler sched;
+  CountingBucket bucket;
+
+  sched.Schedule (& bucket);
+  bucket.Request();
+  RunFor (sched, 5);
+  bucket.Request(); // waits for a token
+  RunFor (sched, 5);
+
+  Check (bucket.m_runs == 1, "token bucket runs once with one token");
+  Check (bucket.IsPending(), "token bucket request waits for a token");
+
+  sched.AbortAllChores();
+  Check (! bucket.IsPending(), "token bucket not pending after abort");
+
+  sched.Schedule (& bucket);
+  RunFor (sched, 200);
+  bucket.Request();
+  RunFor (sched, 100);
+
+  Check (bucket.m_runs == 2, "token bucket runs request after abort");
+  Check (! bucket.IsPending(), "token bucket not pending after run");
+}
+
+
+// ----------------------------------------------------------------------------
+/** Resumable chore that yields on demand and counts its runs.
+ */
+
+class YieldingChore
+  : public ResumableChore
+{
+public:
+  YieldingChore ()
+    : ResumableChore (100), m_yield (false), m_runs (0), m_restarts (0),
+      m_lastRun (0), m_minGap (0xffffffff) { }
+
+  bool m_yield;
+  int m_runs;
+  int m_restarts;
+  uint32_t m_lastRun;           // msec
+  uint32_t m_minGap;            // shortest time between runs, msec
+
+private:
+  virtual void Restart () { ++m_restarts; }
+
+  virtual bool Process ()
+  {
+    uint32_t now = millis();
+    if (m_runs != 0 && now - m_lastRun < m_minGap)
+      {
+        m_minGap = now - m_lastRun;
+      }
+
+    m_lastRun = now;
+    ++m_runs;
+    return (! m_yield);
+  }
+};
+
+
+// ----------------------------------------------------------------------------
+/** A ResumableChore aborted while its work is put off must start
+ * afresh when it is scheduled again, and keep its period instead
+ * of running in a burst to catch up.
+ */
+
+void CheckResumableAbort ()
+{
+  Scheduler top;
+  Scheduler nested (1);
+  YieldingChore chore;
+
+  nested.Schedule (& chore);
+  top.Schedule (& nested);
+  RunFor (top, 150);
+
+  chore.m_yield = true;
+  RunFor (top, 60);
+  Check (chore.IsResuming(), "resumable chore resumes after yield");
+
+  nested.AbortAllChores();
+  Check (! chore.IsResuming(), "resumable chore not resuming after abort");
+
+  chore.m_yield = false;
+  chore.m_minGap = 0xffffffff;
+  nested.Schedule (& chore);
+
+  int runs = chore.m_runs;
+  int restarts = chore.m_restarts;
+  RunFor (top, 1000);
+
+  runs = chore.m_runs - runs;
+  restarts = chore.m_restarts - restarts;
+  Check (runs >= 9 && runs <= 11 && chore.m_minGap >= 99,
+         "resumable chore keeps period after abort");
+  Check (restarts == runs, "resumable chore restarts work after abort");
+}
+
+} // end namespace
+
+
+int
+main ()
+{
+  CheckTokenBucketAbort();
+  CheckResumableAbort();
+
+  if (s_failures == 0)
+    {
+      printf ("all checks passed\n");
+    }
+
+  return (s_failures);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
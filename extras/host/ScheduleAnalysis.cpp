@@ -0,0 +1,396 @@
+/*********************************************************************
+  ScheduleAnalysis.cpp - schedulability analysis of a chore set.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "ScheduleAnalysis.h"
+
+#include <algorithm>
+
+
+namespace {
+
+// give up on busy periods longer than this, micro-seconds
+const uint64_t MAX_BUSY = (uint64_t) 1 << 48;
+
+
+uint64_t Gcd (uint64_t a, uint64_t b)
+{
+  while (b != 0)
+    {
+      uint64_t t = a % b;
+      a = b;
+      b = t;
+    }
+  return (a);
+}
+
+
+uint64_t CeilDiv (uint64_t a, uint64_t b)
+{
+  return (a + b - 1) / b;
+}
+
+
+// Order chores by period, for rate monotonic priority.
+bool ByPeriod (const ChoreTiming & a, const ChoreTiming & b)
+{
+  return (a.m_period < b.m_period);
+}
+
+} // end namespace
+
+
+const uint64_t ScheduleAnalysis::UNBOUNDED;
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * An empty analysis is created.
+ */
+
+ScheduleAnalysis::
+ScheduleAnalysis()
+  : m_utilization (0),
+    m_hyperperiod (0),
+    m_busyPeriod (0),
+    m_rmFeasible (false),
+    m_edfFeasible (false)
+{ }
+
+
+// ----------------------------------------------------------------------------
+/** Add a chore.
+ *
+ * @param[in] id - chore id, for the results
+ * @param[in] period - interval, milli-seconds
+ * @param[in] wcet - worst case run time, micro-seconds
+ */
+
+void ScheduleAnalysis::
+Add (uint8_t id, uint32_t period, uint32_t wcet)
+{
+  if (period == 0)
+    {
+      return; // event chores have no period
+    }
+
+  ChoreTiming ct;
+  ct.m_id = id;
+  ct.m_period = period;
+  ct.m_wcet = wcet;
+  ct.m_rmResponse = 0;
+  ct.m_lateness = 0;
+
+  m_chores.push_back (ct);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Add a chore.
+ *
+ * The interval and id are taken from the chore.  Event chores
+ * are ignored.
+ *
+ * @param[in] chore - chore
+ * @param[in] wcet - worst case run time, micro-seconds
+ */
+
+void ScheduleAnalysis::
+Add (const SchedulerChore & chore, uint32_t wcet)
+{
+  Add (chore.Id(), chore.Interval(), wcet);
+}
+
+
+#if defined (SCHEDULER_HISTOGRAM)
+// ----------------------------------------------------------------------------
+/** Add a chore with its measured run time.
+ *
+ * The worst case run time is the longest run time seen by the
+ * chore's run time histogram.
+ *
+ * @param[in] chore - chore
+ */
+
+void ScheduleAnalysis::
+Add (const SchedulerChore & chore)
+{
+  Add (chore.Id(), chore.Interval(), chore.RunTime().Max());
+}
+#endif
+
+
+// ----------------------------------------------------------------------------
+/** Analyse the chores.
+ *
+ * The chores are sorted by period.
+ */
+
+void ScheduleAnalysis::
+Analyse ()
+{
+  std::stable_sort (m_chores.begin(), m_chores.end(), ByPeriod);
+
+  m_utilization = 0;
+  m_hyperperiod = 1;
+
+  for (size_t i = 0; i < m_chores.size(); ++i)
+    {
+      const ChoreTiming & ct = m_chores[i];
+
+      m_utilization += ct.m_wcet / (ct.m_period * 1000.0);
+
+      if (m_hyperperiod != 0)
+        {
+          uint64_t mult = ct.m_period / Gcd (m_hyperperiod, ct.m_period);
+          m_hyperperiod = (m_hyperperiod > ((uint64_t) 1 << 62) / mult)
+            ? 0 : m_hyperperiod * mult;
+        }
+    }
+
+  m_busyPeriod = FindBusyPeriod();
+
+  m_rmFeasible = (m_busyPeriod != UNBOUNDED);
+  for (size_t i = 0; i < m_chores.size(); ++i)
+    {
+      ChoreTiming & ct = m_chores[i];
+
+      ct.m_rmResponse = RmResponse (i);
+      if (ct.m_rmResponse == UNBOUNDED)
+        {
+          m_rmFeasible = false;
+        }
+
+      ct.m_lateness = (m_busyPeriod != UNBOUNDED)
+        ? m_busyPeriod - ct.m_wcet : UNBOUNDED;
+    }
+
+  m_edfFeasible = (m_busyPeriod != UNBOUNDED) && EdfTest();
+}
+
+
+// ----------------------------------------------------------------------------
+/** Find the length of the longest busy period.
+ *
+ * The longest busy period starts with all chores due at once.
+ *
+ * @return length, micro-seconds, or UNBOUNDED if the busy period
+ * does not end.
+ */
+
+uint64_t ScheduleAnalysis::
+FindBusyPeriod () const
+{
+  if (m_utilization >= 1.0)
+    {
+      return (UNBOUNDED);
+    }
+
+  uint64_t len = 0;
+  for (size_t j = 0; j < m_chores.size(); ++j)
+    {
+      len += m_chores[j].m_wcet;
+    }
+
+  while (len != 0)
+    {
+      uint64_t next = 0;
+      for (size_t j = 0; j < m_chores.size(); ++j)
+        {
+          next += CeilDiv (len, m_chores[j].m_period * (uint64_t) 1000)
+            * m_chores[j].m_wcet;
+        }
+
+      if (next == len || next > MAX_BUSY)
+        {
+          break;
+        }
+
+      len = next;
+    }
+
+  return (len > MAX_BUSY ? UNBOUNDED : len);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Find worst case response time with rate monotonic order.
+ *
+ * Each job of the chore in its level busy period is checked.  A
+ * job may be blocked by one lower priority chore that has just
+ * started, then waits for the higher priority chores due before
+ * it starts.
+ *
+ * @param[in] idx - index of chore, in period order
+ * @return response time, micro-seconds, or UNBOUNDED if a
+ * deadline can be missed.
+ */
+
+uint64_t ScheduleAnalysis::
+RmResponse (size_t idx) const
+{
+  const ChoreTiming & me = m_chores[idx];
+  const uint64_t period = me.m_period * (uint64_t) 1000;
+
+  // longest lower priority chore
+  uint64_t blocking = 0;
+  for (size_t j = idx + 1; j < m_chores.size(); ++j)
+    {
+      blocking = std::max (blocking, (uint64_t) m_chores[j].m_wcet);
+    }
+
+  double util = 0;
+  for (size_t j = 0; j <= idx; ++j)
+    {
+      util += m_chores[j].m_wcet / (m_chores[j].m_period * 1000.0);
+    }
+
+  if (util >= 1.0)
+    {
+      return (UNBOUNDED);
+    }
+
+  // level busy period, including chores of equal period
+  uint64_t level = blocking + me.m_wcet;
+  for (;;)
+    {
+      uint64_t next = blocking;
+      for (size_t j = 0; j <= idx; ++j)
+        {
+          next += CeilDiv (level, m_chores[j].m_period * (uint64_t) 1000)
+            * m_chores[j].m_wcet;
+        }
+
+      if (next == level)
+        {
+          break;
+        }
+
+      if (next > MAX_BUSY)
+        {
+          return (UNBOUNDED);
+        }
+
+      level = next;
+    }
+
+  uint64_t jobs = CeilDiv (level, period);
+  uint64_t worst = 0;
+
+  for (uint64_t q = 0; q < jobs; ++q)
+    {
+      // start time of job q
+      uint64_t start = blocking + q * me.m_wcet;
+      for (;;)
+        {
+          uint64_t next = blocking + q * me.m_wcet;
+          for (size_t j = 0; j < idx; ++j)
+            {
+              next += (start / (m_chores[j].m_period * (uint64_t) 1000) + 1)
+                * m_chores[j].m_wcet;
+            }
+
+          if (next == start)
+            {
+              break;
+            }
+
+          if (next > MAX_BUSY)
+            {
+              return (UNBOUNDED);
+            }
+
+          start = next;
+        }
+
+      uint64_t response = start + me.m_wcet - q * period;
+      if (response > period)
+        {
+          return (UNBOUNDED);
+        }
+
+      worst = std::max (worst, response);
+    }
+
+  return (worst);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Test earliest deadline first order.
+ *
+ * Processor demand test for non-preemptive chores: at each
+ * deadline in the busy period, the run time of the chores due by
+ * then, plus the longest chore due later, must fit.
+ *
+ * @return true if all deadlines are met.
+ */
+
+bool ScheduleAnalysis::
+EdfTest () const
+{
+  std::vector< uint64_t > points;
+
+  for (size_t j = 0; j < m_chores.size(); ++j)
+    {
+      const uint64_t period = m_chores[j].m_period * (uint64_t) 1000;
+      for (uint64_t t = period; t <= m_busyPeriod; t += period)
+        {
+          points.push_back (t);
+        }
+    }
+
+  std::sort (points.begin(), points.end());
+  points.erase (std::unique (points.begin(), points.end()), points.end());
+
+  for (size_t p = 0; p < points.size(); ++p)
+    {
+      const uint64_t t = points[p];
+      uint64_t demand = 0;
+      uint64_t blocking = 0;
+
+      for (size_t j = 0; j < m_chores.size(); ++j)
+        {
+          const ChoreTiming & ct = m_chores[j];
+          const uint64_t period = ct.m_period * (uint64_t) 1000;
+
+          if (period <= t)
+            {
+              demand += (t / period) * ct.m_wcet;
+            }
+          else if (ct.m_wcet > blocking)
+            {
+              blocking = ct.m_wcet;
+            }
+        }
+
+      if (demand + blocking > t)
+        {
+          return (false);
+        }
+    }
+
+  return (true);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
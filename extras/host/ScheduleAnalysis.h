@@ -0,0 +1,148 @@
+/*********************************************************************
+  ScheduleAnalysis.h - schedulability analysis of a chore set.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (ScheduleAnalysis_H_)
+#define ScheduleAnalysis_H_
+
+#include <Scheduler.h>
+
+#include <cstddef>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+/** Timing of one chore, and the results of the analysis.
+ *
+ */
+
+struct ChoreTiming
+{
+  uint8_t m_id;
+  uint32_t m_period;            ///< interval, milli-seconds
+  uint32_t m_wcet;              ///< worst case run time, micro-seconds
+
+  /// Worst case response time with rate monotonic order,
+  /// micro-seconds, or ScheduleAnalysis::UNBOUNDED if it is
+  /// longer than the period.
+  uint64_t m_rmResponse;
+
+  /// Worst case lateness with the scheduler's own order,
+  /// micro-seconds, or ScheduleAnalysis::UNBOUNDED if the
+  /// processor is overloaded.
+  uint64_t m_lateness;
+};
+
+
+// ----------------------------------------------------------------------------
+/** Schedulability analysis.
+ *
+ * This class predicts whether a set of chores fits on a board,
+ * from the interval of each chore and its worst case run time,
+ * such as the maximum of its RunTime() histogram.  Each chore's
+ * deadline is taken to be its next expiration.
+ *
+ * Chores run to completion, so all orders are analysed without
+ * preemption; a chore that is due waits for the chore that is
+ * running.  Three orders are analysed:
+ *
+ * - Rate monotonic: shortest interval first.  The worst case
+ *   response time of each chore is found by non-preemptive
+ *   response time analysis over the chore's busy period.
+ *
+ * - Earliest deadline first: feasibility by the processor demand
+ *   test with blocking, up to the length of the busy period.
+ *
+ * - The scheduler's own order, which runs chores in order of
+ *   expiration time.  Chores due at the same time are first come,
+ *   first served, so a chore can wait for all the work that
+ *   became due before it, and the worst case lateness of a chore
+ *   is the longest busy period less its own run time.
+ *
+ * Times do not include the delay of the loop calling
+ * RunScheduler(), or the scheduler's own overhead.
+ *
+ * Example:
+\code
+ScheduleAnalysis  analysis;
+
+analysis.Add (sensor, 850);
+analysis.Add (display, 12000);
+analysis.Analyse();
+if (analysis.Utilization() > 1.0 || ! analysis.EdfFeasible()) ...
+\endcode
+ */
+
+class ScheduleAnalysis
+{
+public:
+  /// Time that has no bound, as when a deadline is missed.
+  static const uint64_t UNBOUNDED = ~(uint64_t) 0;
+
+  ScheduleAnalysis ();
+
+  void Add (uint8_t id, uint32_t period, uint32_t wcet);
+  void Add (const SchedulerChore & chore, uint32_t wcet);
+#if defined (SCHEDULER_HISTOGRAM)
+  void Add (const SchedulerChore & chore);
+#endif
+
+  void Analyse ();
+
+  /// Return chores, with results after Analyse().
+  const std::vector< ChoreTiming > & Chores() const { return m_chores; }
+
+  /// Return fraction of the processor used.
+  double Utilization() const { return m_utilization; }
+
+  /// Return hyperperiod, milli-seconds, or 0 if it overflows.
+  uint64_t Hyperperiod() const { return m_hyperperiod; }
+
+  /// Return length of the longest busy period, micro-seconds,
+  /// or UNBOUNDED if the processor is overloaded.
+  uint64_t BusyPeriod() const { return m_busyPeriod; }
+
+  /// Return true if all chores meet their deadlines with rate
+  /// monotonic order.
+  bool RmFeasible() const { return m_rmFeasible; }
+
+  /// Return true if all chores meet their deadlines with
+  /// earliest deadline first order.
+  bool EdfFeasible() const { return m_edfFeasible; }
+
+
+private:
+  uint64_t FindBusyPeriod () const;
+  uint64_t RmResponse (size_t idx) const;
+  bool EdfTest () const;
+
+  std::vector< ChoreTiming > m_chores;
+
+  double m_utilization;
+  uint64_t m_hyperperiod;
+  uint64_t m_busyPeriod;
+  bool m_rmFeasible;
+  bool m_edfFeasible;
+};
+
+#endif	// ScheduleAnalysis_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
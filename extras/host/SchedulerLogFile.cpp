@@ -0,0 +1,70 @@
+/*********************************************************************
+  SchedulerLogFile.cpp - load a scheduler log for replay on a host.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "SchedulerLogFile.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+// ----------------------------------------------------------------------------
+/** Load log from a file.
+ *
+ * @param[in] path - name of file
+ * @return true if a log was found in the file.
+ */
+
+bool SchedulerLogFile::
+Load (const char * path)
+{
+  m_data.clear();
+
+  FILE * fp = fopen (path, "rb");
+  if (fp == 0)
+    {
+      return (false);
+    }
+
+  std::vector< uint8_t > raw;
+  uint8_t buf[4096];
+  size_t n;
+
+  while ((n = fread (buf, 1, sizeof (buf), fp)) > 0)
+    {
+      raw.insert (raw.end(), buf, buf + n);
+    }
+  fclose (fp);
+
+  for (size_t i = 0; i + 4 <= raw.size(); ++i)
+    {
+      if (memcmp (& raw[i], "SLOG", 4) == 0)
+        {
+          m_data.assign (raw.begin() + i, raw.end());
+          return (true);
+        }
+    }
+
+  return (false);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,69 @@
+/*********************************************************************
+  SchedulerLogFile.h - load a scheduler log for replay on a host.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (SchedulerLogFile_H_)
+#define SchedulerLogFile_H_
+
+#include <SchedulerLog.h>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+/** Scheduler log file.
+ *
+ * This class loads a recorded SchedulerLog from a file, such as a
+ * capture of the serial port, for replay.  Anything before the
+ * "SLOG" marker in the file is skipped.
+ *
+ * Example:
+\code
+SchedulerLogFile  file;
+if (! file.Load ("capture.bin"))
+  {
+    return (1);
+  }
+
+SchedulerLog  replay (file.Data(), file.Size());
+SchedulerLog::Attach (& replay);
+\endcode
+ */
+
+class SchedulerLogFile
+{
+public:
+  bool Load (const char * path);
+
+  /// Return log data, from the marker on.
+  const uint8_t * Data() const { return m_data.empty() ? 0 : & m_data[0]; }
+
+  /// Return number of bytes of log data.
+  uint32_t Size() const { return m_data.size(); }
+
+
+private:
+  std::vector< uint8_t > m_data;
+};
+
+#endif	// SchedulerLogFile_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,126 @@
+/*********************************************************************
+  SchedulerStateFile.cpp - keep saved scheduler state in a file.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "SchedulerStateFile.h"
+
+#include <chrono>
+#include <cstdio>
+
+
+namespace {
+
+// Wall clock time, milli-seconds.
+uint64_t WallTime()
+{
+  return std::chrono::duration_cast< std::chrono::milliseconds >
+    (std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // end namespace
+
+
+// ----------------------------------------------------------------------------
+/** Save scheduler state to a file.
+ *
+ * The file holds the wall clock time, eight bytes least
+ * significant first, followed by the state block.
+ *
+ * @param[in] path - name of file
+ * @param[in] sched - scheduler to save
+ * @param[in] chores - chores to save
+ * @param[in] count - number of chores
+ * @return true if the file was written.
+ */
+
+bool SchedulerStateFile::
+Save (const char * path, const Scheduler & sched,
+      SchedulerChore * const * chores, uint8_t count)
+{
+  std::vector< uint8_t > buf (8 + 5 + 11 * (uint32_t) count);
+
+  uint64_t now = WallTime();
+  for (int i = 0; i < 8; ++i)
+    {
+      buf[i] = (uint8_t) (now >> (8 * i));
+    }
+
+  uint16_t len = sched.SaveState (chores, count, & buf[8], buf.size() - 8);
+  if (len == 0)
+    {
+      return (false);
+    }
+
+  FILE * fp = fopen (path, "wb");
+  if (fp == 0)
+    {
+      return (false);
+    }
+
+  bool ok = (fwrite (& buf[0], 1, 8 + len, fp) == 8 + (size_t) len);
+  return (fclose (fp) == 0 && ok);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Load scheduler state from a file.
+ *
+ * @param[in] path - name of file
+ * @return true if the file was read.
+ */
+
+bool SchedulerStateFile::
+Load (const char * path)
+{
+  m_data.clear();
+  m_slept = 0;
+
+  FILE * fp = fopen (path, "rb");
+  if (fp == 0)
+    {
+      return (false);
+    }
+
+  uint8_t buf[4096];
+  size_t n = fread (buf, 1, sizeof (buf), fp);
+  fclose (fp);
+
+  if (n <= 8)
+    {
+      return (false);
+    }
+
+  uint64_t then = 0;
+  for (int i = 0; i < 8; ++i)
+    {
+      then |= (uint64_t) buf[i] << (8 * i);
+    }
+
+  uint64_t now = WallTime();
+  uint64_t slept = (now > then) ? now - then : 0;
+  m_slept = (slept > 0xffffffffu) ? 0xffffffffu : (uint32_t) slept;
+  m_data.assign (buf + 8, buf + n);
+
+  return (true);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,79 @@
+/*********************************************************************
+  SchedulerStateFile.h - keep saved scheduler state in a file.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (SchedulerStateFile_H_)
+#define SchedulerStateFile_H_
+
+#include <Scheduler.h>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+/** Scheduler state file.
+ *
+ * This class keeps the block written by Scheduler::SaveState() in
+ * a file, with the time it was saved, so a host program can stop
+ * and later resume its schedule where it left off.  The time
+ * passed since the save is measured with the system clock.
+ *
+ * Example:
+\code
+// on exit
+SchedulerStateFile::Save ("sched.state", the_scheduler, chores, CHORE_COUNT);
+
+// on start, after scheduling the chores
+SchedulerStateFile  file;
+if (file.Load ("sched.state"))
+  {
+    the_scheduler.RestoreState (chores, CHORE_COUNT,
+                                file.Data(), file.Size(), file.Slept());
+  }
+\endcode
+ */
+
+class SchedulerStateFile
+{
+public:
+  static bool Save (const char * path, const Scheduler & sched,
+                    SchedulerChore * const * chores, uint8_t count);
+
+  bool Load (const char * path);
+
+  /// Return saved state.
+  const uint8_t * Data() const { return m_data.empty() ? 0 : & m_data[0]; }
+
+  /// Return number of bytes of saved state.
+  uint16_t Size() const { return m_data.size(); }
+
+  /// Return time passed since the state was saved, milli-seconds.
+  uint32_t Slept() const { return m_slept; }
+
+
+private:
+  std::vector< uint8_t > m_data;
+  uint32_t m_slept;
+};
+
+#endif	// SchedulerStateFile_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
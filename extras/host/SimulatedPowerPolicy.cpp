@@ -0,0 +1,211 @@
+/*********************************************************************
+  SimulatedPowerPolicy.cpp - simulated sleep states for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "SimulatedPowerPolicy.h"
+#include "WProgram.h"
+
+
+// ----------------------------------------------------------------------------
+/** Constructor.
+ *
+ * A policy with no sleep states is created.
+ *
+ * @param[in] active_uw - power drawn while awake, micro-watts
+ */
+
+SimulatedPowerPolicy::
+SimulatedPowerPolicy (uint32_t active_uw)
+  : m_activePower (active_uw)
+{
+  Reset();
+}
+
+
+// ----------------------------------------------------------------------------
+/** Add sleep state.
+ *
+ * States must be added shallowest first.  The name is not copied.
+ *
+ * @param[in] name - name of state, for the report
+ * @param[in] latency - time to wake up, milli-seconds
+ * @param[in] power_uw - power drawn while asleep, micro-watts
+ * @param[in] stops_clock - true if the millis() clock stops
+ */
+
+void SimulatedPowerPolicy::
+AddState (const char * name, uint32_t latency, uint32_t power_uw,
+          bool stops_clock)
+{
+  State state;
+
+  state.m_name = name;
+  state.m_latency = latency;
+  state.m_power = power_uw;
+  state.m_stopsClock = stops_clock;
+  state.m_time = 0;
+  state.m_count = 0;
+
+  m_states.push_back (state);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Sleep while idle.
+ *
+ * The deepest state that can wake up in the idle time is entered
+ * until the wake up time before the next chore, and the wake up
+ * is spent awake.
+ *
+ * @param[in] idle - time until the next chore, milli-seconds
+ * @return time the millis() clock was stopped, milli-seconds.
+ */
+
+uint32_t SimulatedPowerPolicy::
+Sleep (uint32_t idle)
+{
+  int pick = -1;
+  for (unsigned i = 0; i < m_states.size(); ++i)
+    {
+      if (m_states[i].m_latency <= idle)
+        {
+          pick = i;
+        }
+    }
+
+  if (pick < 0)
+    {
+      // stay awake
+      HostClock::Advance ((uint64_t) idle * 1000);
+      return (0);
+    }
+
+  State & state = m_states[pick];
+  state.m_time += idle - state.m_latency;
+  ++state.m_count;
+
+  if (state.m_stopsClock)
+    {
+      m_stopped += idle;
+      return (idle);
+    }
+
+  HostClock::Advance ((uint64_t) idle * 1000);
+  return (0);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Start counting again.
+ *
+ */
+
+void SimulatedPowerPolicy::
+Reset()
+{
+  for (unsigned i = 0; i < m_states.size(); ++i)
+    {
+      m_states[i].m_time = 0;
+      m_states[i].m_count = 0;
+    }
+
+  m_start = HostClock::Now();
+  m_stopped = 0;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Get time since counting started.
+ *
+ * This is the time on the simulated clock plus the time it was
+ * stopped, as a wall clock would show.
+ *
+ * @return time in milli-seconds.
+ */
+
+uint64_t SimulatedPowerPolicy::
+ElapsedTime() const
+{
+  return (HostClock::Now() - m_start) / 1000 + m_stopped;
+}
+
+
+// ----------------------------------------------------------------------------
+/** Estimate energy used since counting started.
+ *
+ * @return energy in milli-joules.
+ */
+
+double SimulatedPowerPolicy::
+Energy() const
+{
+  uint64_t asleep = 0;
+  double energy = 0;
+
+  for (unsigned i = 0; i < m_states.size(); ++i)
+    {
+      asleep += m_states[i].m_time;
+      energy += (double) m_states[i].m_time * m_states[i].m_power;
+    }
+
+  uint64_t elapsed = ElapsedTime();
+  uint64_t awake = (elapsed > asleep) ? elapsed - asleep : 0;
+  energy += (double) awake * m_activePower;
+
+  // micro-watts times milli-seconds is nano-joules
+  return (energy / 1e6);
+}
+
+
+// ----------------------------------------------------------------------------
+/** Write time and energy of each state.
+ *
+ * @param[in] out - file to write to
+ */
+
+void SimulatedPowerPolicy::
+Report (FILE * out) const
+{
+  uint64_t elapsed = ElapsedTime();
+  uint64_t asleep = 0;
+
+  fprintf (out, "%-16s %10s %12s %12s\n", "state", "entries", "time ms", "energy mJ");
+
+  for (unsigned i = 0; i < m_states.size(); ++i)
+    {
+      const State & state = m_states[i];
+      asleep += state.m_time;
+
+      fprintf (out, "%-16s %10u %12llu %12.3f\n", state.m_name, state.m_count,
+               (unsigned long long) state.m_time,
+               (double) state.m_time * state.m_power / 1e6);
+    }
+
+  uint64_t awake = (elapsed > asleep) ? elapsed - asleep : 0;
+  fprintf (out, "%-16s %10s %12llu %12.3f\n", "awake", "",
+           (unsigned long long) awake, (double) awake * m_activePower / 1e6);
+  fprintf (out, "total %llu ms, %.3f mJ, average %.1f uW\n",
+           (unsigned long long) elapsed, Energy(),
+           elapsed ? Energy() * 1e6 / elapsed : 0.0);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,111 @@
+/*********************************************************************
+  SimulatedPowerPolicy.h - simulated sleep states for the scheduler.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#if !defined (SimulatedPowerPolicy_H_)
+#define SimulatedPowerPolicy_H_
+
+#include <Scheduler.h>
+
+#include <cstdio>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+/** Simulated power policy.
+ *
+ * This class stands in for a board's power policy on the host.
+ * It is given a list of sleep states, shallowest first, each with
+ * its wake up time, its power draw, and whether it stops the
+ * millis() clock.  Each time the scheduler is idle, the deepest
+ * state that can wake up in time is picked and the simulated
+ * clock is moved to the next chore, or left alone for states
+ * that stop the clock, as on a board.  If no state fits, the
+ * time is spent awake.
+ *
+ * The time spent in each state is counted, so the energy used by
+ * a schedule can be estimated and compared.
+ *
+ * Example:
+\code
+SimulatedPowerPolicy  power (15000);   // 15 mW awake
+power.AddState ("idle", 0, 6000, false);
+power.AddState ("power down", 2, 5, true);
+
+the_scheduler.Power (& power);
+while (HostClock::Now() < 60000000)
+  {
+    the_scheduler.RunScheduler();
+  }
+
+power.Report (stdout);
+\endcode
+ */
+
+class SimulatedPowerPolicy
+  : public PowerPolicy
+{
+public:
+  SimulatedPowerPolicy (uint32_t active_uw);
+
+  void AddState (const char * name, uint32_t latency, uint32_t power_uw,
+                 bool stops_clock);
+
+  virtual uint32_t Sleep (uint32_t idle);
+
+  void Reset();
+
+  /// Return time spent in a state, milli-seconds.
+  uint64_t StateTime (unsigned state) const { return m_states[state].m_time; }
+
+  /// Return number of times a state was entered.
+  uint32_t StateCount (unsigned state) const { return m_states[state].m_count; }
+
+  uint64_t ElapsedTime() const;
+  double Energy() const;
+  void Report (FILE * out) const;
+
+
+private:
+  struct State
+  {
+    const char * m_name;
+    uint32_t m_latency;         // msec
+    uint32_t m_power;           // micro-watts
+    bool m_stopsClock;
+
+    uint64_t m_time;            // msec
+    uint32_t m_count;
+  };
+
+  std::vector< State > m_states;
+  uint32_t m_activePower;       // micro-watts
+
+  /// Simulated clock when counting started, micro-seconds.
+  uint64_t m_start;
+
+  /// Time the millis() clock was stopped, milli-seconds.
+  uint64_t m_stopped;
+};
+
+#endif	// SimulatedPowerPolicy_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
@@ -0,0 +1,83 @@
+/*********************************************************************
+  WProgram.cpp - host stand-in for the Arduino core.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+#include "WProgram.h"
+
+
+namespace {
+
+// simulated time, micro-seconds
+uint64_t s_now = 0;
+
+} // end namespace
+
+
+uint32_t millis()
+{
+  return (uint32_t) (s_now / 1000);
+}
+
+
+uint32_t micros()
+{
+  return (uint32_t) s_now;
+}
+
+
+void pinMode (uint8_t, uint8_t)
+{
+
+}
+
+
+void digitalWrite (uint8_t, uint8_t)
+{
+
+}
+
+
+// ============================================================================
+// Host Clock methods
+//
+
+void HostClock::
+Set (uint64_t usec)
+{
+  s_now = usec;
+}
+
+
+void HostClock::
+Advance (uint64_t usec)
+{
+  s_now += usec;
+}
+
+
+uint64_t HostClock::
+Now ()
+{
+  return (s_now);
+}
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
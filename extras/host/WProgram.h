@@ -0,0 +1,85 @@
+/*********************************************************************
+  WProgram.h - host stand-in for the Arduino core.
+  Copyright (c) 2009 Linus Sherrill.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+***********************************************************************/
+
+//
+// This header stands in for the Arduino core when the scheduler
+// is built on a host (Linux) machine, for simulation, tools and
+// benchmarks.  Put this directory ahead of the library directory
+// on the include path.  The clock is simulated and only advances
+// when told to, so runs are repeatable.
+//
+
+#if !defined (WProgram_H_)
+#define WProgram_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#define LOW     0
+#define HIGH    1
+#define INPUT   0
+#define OUTPUT  1
+
+uint32_t millis();
+uint32_t micros();
+
+void pinMode (uint8_t pin, uint8_t mode);
+void digitalWrite (uint8_t pin, uint8_t val);
+
+
+// ----------------------------------------------------------------------------
+/** Simulated clock.
+ *
+ * The clock behind millis() and micros().
+ */
+
+class HostClock
+{
+public:
+  /// Set the clock, micro-seconds.
+  static void Set (uint64_t usec);
+
+  /// Move the clock forward, micro-seconds.
+  static void Advance (uint64_t usec);
+
+  /// Return the clock, micro-seconds.
+  static uint64_t Now ();
+};
+
+
+// ----------------------------------------------------------------------------
+/** Output stream.
+ *
+ * Minimal version of the Arduino Print class.
+ */
+
+class Print
+{
+public:
+  virtual ~Print() { }
+  virtual size_t write (uint8_t val) = 0;
+};
+
+#endif	// WProgram_H_
+
+// Local Variables:
+// mode: c++
+// fill-column: 64
+// end:
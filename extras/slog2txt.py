@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+#
+# slog2txt.py - print a SchedulerLog recording as text.
+# Copyright (c) 2009 Linus Sherrill.  All right reserved.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2.1 of the License, or (at your option) any later version.
+#
+# Reads a log recorded by SchedulerLog, for example a capture of
+# the serial port, and prints one line per entry, with clock reads
+# as absolute values.
+#
+# usage: slog2txt.py capture.bin
+#
+
+import sys
+
+MAGIC = b"SLOG"
+KINDS = ["time", "micros", "input", "dispatch"]
+
+
+def decode(data):
+    """Return list of (offset, kind, value) from the log in data."""
+    pos = data.find(MAGIC)
+    if pos < 0:
+        raise ValueError("no log found")
+
+    version = bytearray(data[pos + 4:pos + 5])[0]
+    if version != 1:
+        raise ValueError("unsupported log version %d" % version)
+
+    data = bytearray(data)
+    prev = [0, 0]
+    entries = []
+    pos += 5
+    while pos < len(data):
+        start = pos
+        byte = data[pos]
+        pos += 1
+
+        kind = byte >> 6
+        value = byte & 0x1f
+        shift = 5
+        more = byte & 0x20
+        while more:
+            if pos >= len(data):
+                return entries
+            byte = data[pos]
+            pos += 1
+            value |= (byte & 0x7f) << shift
+            shift += 7
+            more = byte & 0x80
+
+        if kind < 2:
+            diff = (value >> 1) ^ -(value & 1)
+            prev[kind] = (prev[kind] + diff) % 2**32
+            value = prev[kind]
+
+        entries.append((start, kind, value))
+    return entries
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write("usage: slog2txt.py capture.bin\n")
+        return 1
+
+    with open(argv[1], "rb") as f:
+        entries = decode(f.read())
+
+    for offset, kind, value in entries:
+        print("%8d %-8s %u" % (offset, KINDS[kind], value))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
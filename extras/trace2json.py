@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+#
+# trace2json.py - convert a SchedulerTrace dump to Chrome trace JSON.
+# Copyright (c) 2009 Linus Sherrill.  All right reserved.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2.1 of the License, or (at your option) any later version.
+#
+# Reads the binary block written by SchedulerTrace::Dump(), for
+# example a capture of the serial port, and writes a JSON file that
+# can be opened in chrome://tracing or https://ui.perfetto.dev.
+# Each chore is shown as its own track.
+#
+# usage: trace2json.py capture.bin [out.json]
+#
+
+import json
+import struct
+import sys
+
+MAGIC = b"STRC"
+REASONS = ["dispatch", "schedule", "reschedule", "abort", "trigger"]
+
+
+def decode(data):
+    """Return list of records from the first trace block in data."""
+    pos = data.find(MAGIC)
+    if pos < 0:
+        raise ValueError("no trace block found")
+
+    version, size, count = struct.unpack_from("<BBH", data, pos + 4)
+    if version != 1:
+        raise ValueError("unsupported trace version %d" % version)
+
+    records = []
+    pos += 8
+    for i in range(count):
+        chore, reason, duration, target, start = \
+            struct.unpack_from("<BBHII", data, pos + i * size)
+        records.append(dict(chore=chore, reason=reason, duration=duration,
+                            target=target, start=start))
+    return records
+
+
+def to_chrome(records):
+    """Convert records to Chrome trace events."""
+    events = []
+    for rec in records:
+        if rec["reason"] < len(REASONS):
+            name = REASONS[rec["reason"]]
+        else:
+            name = "reason %d" % rec["reason"]
+
+        event = dict(pid=0, tid=rec["chore"], ts=rec["start"] * 1000,
+                     cat=name, args=dict(target_ms=rec["target"]))
+
+        if rec["reason"] == 0:
+            lateness = (rec["start"] - rec["target"] + 2**31) % 2**32 - 2**31
+            event.update(name="chore %d" % rec["chore"], ph="X",
+                         dur=rec["duration"])
+            event["args"]["lateness_ms"] = lateness
+        else:
+            event.update(name=name, ph="i", s="t")
+
+        events.append(event)
+
+    for chore in sorted(set(rec["chore"] for rec in records)):
+        events.append(dict(pid=0, tid=chore, ph="M", name="thread_name",
+                           args=dict(name="chore %d" % chore)))
+
+    return dict(traceEvents=events, displayTimeUnit="ms")
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.stderr.write("usage: %s capture.bin [out.json]\n" % argv[0])
+        return 1
+
+    with open(argv[1], "rb") as f:
+        trace = to_chrome(decode(f.read()))
+
+    if len(argv) > 2:
+        with open(argv[2], "w") as f:
+            json.dump(trace, f, indent=1)
+    else:
+        json.dump(trace, sys.stdout, indent=1)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))